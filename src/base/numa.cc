@@ -0,0 +1,150 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2018 by contributors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//------------------------------------------------------------------------------
+
+/*!
+*  Copyright (c) 2018 by Contributors
+* \file numa.cc
+* \brief This file reads the NUMA topology from sysfs.
+*/
+#include "src/base/numa.h"
+
+#include <dirent.h>
+#include <sched.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <thread>
+
+#include "src/base/common.h"
+#include "src/base/split_string.h"
+
+static const char* kNodeDir = "/sys/devices/system/node";
+
+// Nodes set by SetNumaNodes()
+static std::mutex override_mutex;
+static std::vector<NumaNode> override_nodes;
+
+// Parse "0-3,8-11"
+bool ParseCpuList(const std::string& str, std::vector<int>* cpus) {
+  CHECK_NOTNULL(cpus);
+  cpus->clear();
+  std::vector<std::string> ranges;
+  SplitStringUsing(str, ",\n", &ranges);
+  for (const std::string& range : ranges) {
+    char* end = nullptr;
+    long first = strtol(range.c_str(), &end, 10);
+    long last = first;
+    if (end == range.c_str() || first < 0) {
+      return false;
+    }
+    if (*end == '-') {
+      const char* begin = end + 1;
+      last = strtol(begin, &end, 10);
+      if (end == begin || last < first) {
+        return false;
+      }
+    }
+    if (*end != '\0') {
+      return false;
+    }
+    for (long cpu = first; cpu <= last; ++cpu) {
+      cpus->push_back((int)cpu);
+    }
+  }
+  return true;
+}
+
+// CPUs of sched_getaffinity
+void GetAffinityCpus(std::vector<int>* cpus) {
+  CHECK_NOTNULL(cpus);
+  cpus->clear();
+#ifdef __linux__
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  if (sched_getaffinity(0, sizeof(cpu_set_t), &cpu_set) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &cpu_set)) {
+        cpus->push_back(cpu);
+      }
+    }
+  }
+#endif
+  if (cpus->empty()) {
+    int num_cpu = std::max(1u, std::thread::hardware_concurrency());
+    for (int cpu = 0; cpu < num_cpu; ++cpu) {
+      cpus->push_back(cpu);
+    }
+  }
+}
+
+// Read node*/cpulist
+void GetNumaNodes(std::vector<NumaNode>* nodes) {
+  CHECK_NOTNULL(nodes);
+  {
+    std::lock_guard<std::mutex> lock(override_mutex);
+    if (!override_nodes.empty()) {
+      *nodes = override_nodes;
+      return;
+    }
+  }
+  nodes->clear();
+  std::vector<int> allowed;
+  GetAffinityCpus(&allowed);
+  DIR* dir = opendir(kNodeDir);
+  if (dir != nullptr) {
+    struct dirent* entry = nullptr;
+    while ((entry = readdir(dir)) != nullptr) {
+      std::string name(entry->d_name);
+      if (name.size() <= 4 || name.compare(0, 4, "node") != 0 ||
+          name.find_first_not_of("0123456789", 4) != std::string::npos) {
+        continue;
+      }
+      std::ifstream file(std::string(kNodeDir) + "/" + name + "/cpulist");
+      std::string list;
+      NumaNode node;
+      node.id = atoi(name.c_str() + 4);
+      std::vector<int> cpus;
+      if (!std::getline(file, list) || !ParseCpuList(list, &cpus)) {
+        continue;
+      }
+      std::sort(cpus.begin(), cpus.end());
+      std::set_intersection(cpus.begin(), cpus.end(),
+                            allowed.begin(), allowed.end(),
+                            std::back_inserter(node.cpus));
+      // Nodes of memory only, or out of the affinity have no CPUs
+      if (!node.cpus.empty()) {
+        nodes->push_back(node);
+      }
+    }
+    closedir(dir);
+  }
+  if (nodes->empty()) {
+    NumaNode node;
+    node.cpus = allowed;
+    nodes->push_back(node);
+  }
+  std::sort(nodes->begin(), nodes->end(), 
+    [](const NumaNode& a, const NumaNode& b) { return a.id < b.id; });
+}
+
+// Test hook of GetNumaNodes()
+void SetNumaNodes(const std::vector<NumaNode>& nodes) {
+  std::lock_guard<std::mutex> lock(override_mutex);
+  override_nodes = nodes;
+}
@@ -0,0 +1,69 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2018 by contributors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//------------------------------------------------------------------------------
+
+/*!
+*  Copyright (c) 2018 by Contributors
+* \file numa.h
+* \brief This file provides the NUMA topology of the machine.
+*/
+#ifndef XFOREST_BASE_NUMA_H_
+#define XFOREST_BASE_NUMA_H_
+
+#include <string>
+#include <vector>
+
+/*!
+* \brief A NUMA node (socket) and its online CPUs.
+*/
+struct NumaNode {
+  int id = 0;
+  std::vector<int> cpus;
+};
+
+/*!
+* \brief Parse a CPU list of sysfs, e.g., "0-3,8-11" or "0,2".
+* \param str the CPU list
+* \param cpus CPU ids in the list
+* \return true for success and false for a malformed list.
+*/
+bool ParseCpuList(const std::string& str, std::vector<int>* cpus);
+
+/*!
+* \brief Get the CPUs this process may run on (sched_getaffinity on
+* Linux, e.g., restricted by taskset or a cgroup), or all of the CPUs
+* if the affinity is not available.
+* \param cpus CPU ids in ascending order
+*/
+void GetAffinityCpus(std::vector<int>* cpus);
+
+/*!
+* \brief Get the NUMA nodes from /sys/devices/system/node. The CPUs of
+* each node are limited to GetAffinityCpus(), and the nodes without any
+* of them are dropped. If the directory is not available (e.g., not
+* Linux, or a kernel without NUMA), the CPUs are returned as node 0.
+* \param nodes NUMA nodes ordered by id
+*/
+void GetNumaNodes(std::vector<NumaNode>* nodes);
+
+/*!
+* \brief Override the nodes returned by GetNumaNodes(), e.g., to test
+* the code of many nodes on a machine of one node. The nodes are
+* returned as given, and an empty list restores the topology of sysfs.
+* \param nodes NUMA nodes ordered by id
+*/
+void SetNumaNodes(const std::vector<NumaNode>& nodes);
+
+#endif  // XFOREST_BASE_NUMA_H_
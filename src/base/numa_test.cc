@@ -0,0 +1,77 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2018 by contributors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//------------------------------------------------------------------------------
+
+/*!
+*  Copyright (c) 2018 by Contributors
+* \file numa_test.cc
+* \brief This file tests numa.h file.
+*/
+#include "gtest/gtest.h"
+
+#include <algorithm>
+
+#include "src/base/numa.h"
+
+TEST(NumaTest, Parse_cpu_list) {
+  std::vector<int> cpus;
+  EXPECT_TRUE(ParseCpuList("0-3,8-9\n", &cpus));
+  std::vector<int> expect = {0, 1, 2, 3, 8, 9};
+  EXPECT_EQ(cpus, expect);
+  EXPECT_TRUE(ParseCpuList("5", &cpus));
+  EXPECT_EQ(cpus, std::vector<int>(1, 5));
+  EXPECT_TRUE(ParseCpuList("", &cpus));
+  EXPECT_TRUE(cpus.empty());
+  EXPECT_FALSE(ParseCpuList("3-1", &cpus));
+  EXPECT_FALSE(ParseCpuList("a", &cpus));
+  EXPECT_FALSE(ParseCpuList("1-", &cpus));
+}
+
+TEST(NumaTest, Get_numa_nodes) {
+  std::vector<int> allowed;
+  GetAffinityCpus(&allowed);
+  ASSERT_FALSE(allowed.empty());
+  EXPECT_TRUE(std::is_sorted(allowed.begin(), allowed.end()));
+  std::vector<NumaNode> nodes;
+  GetNumaNodes(&nodes);
+  ASSERT_FALSE(nodes.empty());
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    EXPECT_FALSE(nodes[i].cpus.empty());
+    if (i > 0) {
+      EXPECT_LT(nodes[i - 1].id, nodes[i].id);
+    }
+    // Only the CPUs this process may run on
+    for (int cpu : nodes[i].cpus) {
+      EXPECT_TRUE(std::binary_search(allowed.begin(), allowed.end(), cpu));
+    }
+  }
+}
+
+TEST(NumaTest, Set_numa_nodes) {
+  std::vector<NumaNode> nodes(2);
+  nodes[0].cpus.push_back(0);
+  nodes[1].id = 1;
+  nodes[1].cpus.push_back(0);
+  SetNumaNodes(nodes);
+  std::vector<NumaNode> get_nodes;
+  GetNumaNodes(&get_nodes);
+  ASSERT_EQ(get_nodes.size(), 2);
+  EXPECT_EQ(get_nodes[1].id, 1);
+  EXPECT_EQ(get_nodes[1].cpus, nodes[1].cpus);
+  // Back to sysfs
+  SetNumaNodes(std::vector<NumaNode>());
+  GetNumaNodes(&get_nodes);
+  EXPECT_FALSE(get_nodes.empty());
+}
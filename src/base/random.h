@@ -0,0 +1,161 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2018 by contributors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//------------------------------------------------------------------------------
+
+/*!
+*  Copyright (c) 2018 by Contributors
+* \file random.h
+* \brief This file provides a counter-based random number generator.
+*/
+#ifndef XFOREST_BASE_RANDOM_H_
+#define XFOREST_BASE_RANDOM_H_
+
+#include <utility>
+
+#include "src/base/common.h"
+
+/*!
+* \brief Philox is the Philox4x32-10 counter-based random number generator
+* (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3", SC'11).
+* The i-th number of a stream is a pure function of (seed, stream id, i),
+* hence there is no state shared between threads, and any number of the
+* stream can be computed directly by At(i). A stream is keyed by the seed
+* and two 32-bit ids, e.g., (random_state, tree id, node id), so that the
+* result does not depend on which thread or in which order it is used.
+* Basic Usage:
+*
+*   Philox rng(seed, tree_id, node_id);
+*   uint32 a = rng();            // next number of the stream
+*   uint32 b = rng.Uniform(10);  // next number in [0, 10)
+*   uint32 c = rng.At(100);      // the 100-th number of the stream
+*
+* Philox satisfies UniformRandomBitGenerator, but note that the std
+* distributions are implementation-defined, so Uniform() should be used
+* for results that are reproducible across platforms.
+*/
+class Philox {
+ public:
+  typedef uint32 result_type;
+
+  /*!
+  * \brief Constructor.
+  * \param seed random seed
+  * \param id_0 first id of the stream
+  * \param id_1 second id of the stream
+  */
+  explicit Philox(uint64 seed, uint32 id_0 = 0, uint32 id_1 = 0) {
+    key_[0] = (uint32)seed;
+    key_[1] = (uint32)(seed >> 32);
+    id_[0] = id_0;
+    id_[1] = id_1;
+  }
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() { return kUInt32Max; }
+
+  /*!
+  * \brief Next number of the stream.
+  */
+  inline result_type operator()() {
+    if ((pos_ >> 2) != block_id_) {
+      block_id_ = pos_ >> 2;
+      Block(block_id_, block_);
+    }
+    return block_[pos_++ & 3];
+  }
+
+  /*!
+  * \brief Next number of the stream in [0, n), which is mapped
+  * by multiplication instead of modulo.
+  */
+  inline uint32 Uniform(uint32 n) {
+    return ((uint64)(*this)() * n) >> 32;
+  }
+
+  /*!
+  * \brief The pos-th number of the stream, which does
+  * not change the position of operator().
+  */
+  inline result_type At(uint64 pos) const {
+    uint32 out[4];
+    Block(pos >> 2, out);
+    return out[pos & 3];
+  }
+
+  /*!
+  * \brief The pos-th number of the stream in [0, n).
+  */
+  inline uint32 UniformAt(uint64 pos, uint32 n) const {
+    return ((uint64)At(pos) * n) >> 32;
+  }
+
+  /*!
+  * \brief Set the position of operator().
+  */
+  inline void Seek(uint64 pos) {
+    pos_ = pos;
+  }
+
+  /*!
+  * \brief Philox4x32-10 bijection of a counter under a key.
+  */
+  static inline void Philox4x32(const uint32 ctr[4],
+                                const uint32 key[2],
+                                uint32 out[4]) {
+    static const uint32 kM0 = 0xD2511F53;
+    static const uint32 kM1 = 0xCD9E8D57;
+    static const uint32 kW0 = 0x9E3779B9;
+    static const uint32 kW1 = 0xBB67AE85;
+    uint32 c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+    uint32 k0 = key[0], k1 = key[1];
+    for (int r = 0; r < 10; ++r) {
+      uint64 p0 = (uint64)kM0 * c0;
+      uint64 p1 = (uint64)kM1 * c2;
+      uint32 n0 = (uint32)(p1 >> 32) ^ c1 ^ k0;
+      uint32 n2 = (uint32)(p0 >> 32) ^ c3 ^ k1;
+      c1 = (uint32)p1;
+      c3 = (uint32)p0;
+      c0 = n0;
+      c2 = n2;
+      k0 += kW0;
+      k1 += kW1;
+    }
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+  }
+
+ private:
+  /*! \brief Key made of the seed */
+  uint32 key_[2];
+  /*! \brief Stream ids, the high words of the counter */
+  uint32 id_[2];
+  /*! \brief Position of operator() */
+  uint64 pos_ = 0;
+  /*! \brief Cached block of operator() */
+  uint64 block_id_ = kUInt64Max;
+  uint32 block_[4];
+
+  /*!
+  * \brief The i-th block (4 numbers) of the stream.
+  */
+  inline void Block(uint64 i, uint32 out[4]) const {
+    uint32 ctr[4] = { (uint32)i, (uint32)(i >> 32), id_[0], id_[1] };
+    Philox4x32(ctr, key_, out);
+  }
+};
+
+#endif  // XFOREST_BASE_RANDOM_H_
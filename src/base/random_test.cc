@@ -0,0 +1,66 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2018 by contributors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//------------------------------------------------------------------------------
+
+/*!
+*  Copyright (c) 2018 by Contributors
+* \file random_test.cc
+* \brief This file tests random.h file.
+*/
+#include "gtest/gtest.h"
+
+#include <vector>
+
+#include "src/base/random.h"
+
+// Known answers of Random123
+TEST(PhiloxTest, Known_answer) {
+  uint32 out[4];
+  uint32 ctr_0[4] = { 0, 0, 0, 0 };
+  uint32 key_0[2] = { 0, 0 };
+  Philox::Philox4x32(ctr_0, key_0, out);
+  EXPECT_EQ(out[0], 0x6627e8d5u);
+  EXPECT_EQ(out[1], 0xe169c58du);
+  EXPECT_EQ(out[2], 0xbc57ac4cu);
+  EXPECT_EQ(out[3], 0x9b00dbd8u);
+  uint32 ctr_1[4] = { 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344 };
+  uint32 key_1[2] = { 0xa4093822, 0x299f31d0 };
+  Philox::Philox4x32(ctr_1, key_1, out);
+  EXPECT_EQ(out[0], 0xd16cfe09u);
+  EXPECT_EQ(out[1], 0x94fdccebu);
+  EXPECT_EQ(out[2], 0x5001e420u);
+  EXPECT_EQ(out[3], 0x24126ea1u);
+}
+
+TEST(PhiloxTest, Stream) {
+  Philox rng(1231, 3, 7);
+  std::vector<uint32> seq;
+  for (int i = 0; i < 10; ++i) {
+    seq.push_back(rng());
+  }
+  // Random access
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(rng.At(i), seq[i]);
+  }
+  rng.Seek(5);
+  EXPECT_EQ(rng(), seq[5]);
+  EXPECT_EQ(rng(), seq[6]);
+  // Different streams
+  Philox other(1231, 3, 8);
+  EXPECT_NE(other.At(0), seq[0]);
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_LT(rng.Uniform(17), 17u);
+  }
+}
@@ -23,6 +23,11 @@
 #ifndef XFOREST_BASE_THREAD_POOL_H_
 #define XFOREST_BASE_THREAD_POOL_H_
 
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 #include <vector>
 #include <queue>
 #include <memory>
@@ -75,6 +80,13 @@ class ThreadPool {
   */
   size_t ThreadNumber();
 
+  /*!
+  * \brief Pin the i-th thread to the core cpus[i % cpus.size()],
+  * which is only supported on Linux.
+  * \return true for success and false for error.
+  */
+  bool Pin(const std::vector<int>& cpus);
+
 private:
     /*! \breif need to keep track of threads so we can join them */
     std::vector<std::thread> workers;
@@ -162,6 +174,26 @@ inline size_t ThreadPool::ThreadNumber() {
   return workers.size();
 }
 
+/*!
+* \brief Pin threads to cores
+*/
+inline bool ThreadPool::Pin(const std::vector<int>& cpus) {
+  CHECK(!cpus.empty());
+#ifdef __linux__
+  bool ok = true;
+  for (size_t i = 0; i < workers.size(); ++i) {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(cpus[i % cpus.size()], &cpu_set);
+    ok &= pthread_setaffinity_np(workers[i].native_handle(),
+                                 sizeof(cpu_set_t), &cpu_set) == 0;
+  }
+  return ok;
+#else
+  return false;
+#endif
+}
+
 /*!
 * \breif The destructor joins all threads
 */
@@ -21,6 +21,7 @@
 */
 #include "gtest/gtest.h"
 
+#include "src/base/numa.h"
 #include "src/base/thread_pool.h"
 
 void func(int id) {
@@ -66,3 +67,18 @@ TEST(ThreadPoolTest, Sum_test) {
   int sum = a1 + a2 + a3 + a4 + a5;
   EXPECT_EQ(sum, 75);
 }
+
+TEST(ThreadPoolTest, Pin_test) {
+  // CPU 0 may be out of the affinity of this process
+  std::vector<int> cpus;
+  GetAffinityCpus(&cpus);
+  ASSERT_FALSE(cpus.empty());
+  ThreadPool pool(2);
+  EXPECT_TRUE(pool.Pin(std::vector<int>(1, cpus[0])));
+  std::atomic_int sum { 0 };
+  for (int i = 0; i < 10; ++i) {
+    pool.enqueue([&sum]() { sum++; });
+  }
+  pool.Sync(10);
+  EXPECT_EQ(sum, 10);
+}
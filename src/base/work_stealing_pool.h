@@ -0,0 +1,332 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2018 by contributors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//------------------------------------------------------------------------------
+
+/*!
+*  Copyright (c) 2018 by Contributors
+* \file work_stealing_pool.h
+* \brief This file provides a work-stealing thread pool for
+* nested parallelism used by xforest.
+*/
+#ifndef XFOREST_BASE_WORK_STEALING_POOL_H_
+#define XFOREST_BASE_WORK_STEALING_POOL_H_
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+
+#include "src/base/common.h"
+
+/*!
+* \brief A group of tasks that can be waited together.
+*/
+struct TaskGroup {
+  /*! \breif number of unfinished tasks */
+  std::atomic_int pending { 0 };
+  /*! \brief group of the task that spawned this group
+   * (nullptr if spawned outside the tasks), which is read by
+   * the threads looking for the tasks of a waited group */
+  std::atomic<TaskGroup*> parent { nullptr };
+};
+
+/*!
+* \brief WorkStealingPool creates N threads upon its creation, and each
+* thread has its own task deque. A task spawned by a worker is pushed to
+* the worker's own deque, which is popped in LIFO order by the owner and
+* stolen in FIFO order by idle workers. Waiting for a task group executes
+* other pending tasks instead of blocking, so tasks can spawn and wait for
+* sub-tasks (e.g., a tree task spawns node-split tasks) without deadlock,
+* and idle workers steal the sub-tasks of busy ones. A waiting thread
+* only executes the tasks of the waited group and of the groups spawned
+* by them, so a tree task waiting for its node chunks does not pick up
+* another tree task, and the nesting is as deep as the groups are.
+* Basic Usage:
+*
+*   WorkStealingPool pool(4);
+*   TaskGroup group;
+*   for (int i = 0; i < 10; ++i) {
+*     pool.Spawn(&group, [&pool, i]() {
+*       TaskGroup sub_group;
+*       pool.Spawn(&sub_group, [i]() { ... });
+*       pool.Spawn(&sub_group, [i]() { ... });
+*       pool.Wait(&sub_group);
+*     });
+*   }
+*   pool.Wait(&group);
+*/
+class WorkStealingPool {
+ public:
+  /*!
+  * \breif Constructor and Destructor
+  */
+  explicit WorkStealingPool(size_t threads);
+  ~WorkStealingPool();
+
+  /*!
+  * \brief Add task to the pool.
+  * \param group task group of the task
+  * \param task task function
+  */
+  void Spawn(TaskGroup* group, std::function<void()> task);
+
+  /*!
+  * \brief Wait all tasks of the group to finish, and
+  * execute pending tasks while waiting.
+  */
+  void Wait(TaskGroup* group);
+
+  /*!
+  * \breif Return the number of threads
+  */
+  size_t ThreadNumber() const {
+    return workers.size();
+  }
+
+ private:
+  /*!
+  * \brief Task and its group.
+  */
+  struct Task {
+    std::function<void()> func;
+    TaskGroup* group = nullptr;
+  };
+  /*!
+  * \brief Task deque of a worker.
+  */
+  struct TaskDeque {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+  /*! \breif need to keep track of threads so we can join them */
+  std::vector<std::thread> workers;
+  /*! \brief task deques of workers, and the last one is
+   * shared by the threads outside the pool */
+  std::vector<std::unique_ptr<TaskDeque>> deques;
+  /*! \brief number of tasks in all deques */
+  std::atomic_int queued { 0 };
+  /*! \brief number of tasks ever spawned */
+  std::atomic<uint64> spawned { 0 };
+  /*! \brief synchronization */
+  std::mutex sleep_mutex;
+  std::condition_variable sleep_condition;
+  std::condition_variable done_condition;
+  bool stop;
+
+  /*!
+  * \brief Id of current thread in this pool, and
+  * the id of deque shared by other threads.
+  */
+  size_t WorkerId() const;
+
+  /*!
+  * \brief Get a task from own deque, or steal from others.
+  * \param id id of current thread
+  * \param group only take the tasks of the group and its descendant
+  * groups, or any task if it is nullptr
+  * \param task the task
+  */
+  bool TryPop(size_t id, const TaskGroup* group, Task* task);
+
+  /*!
+  * \brief Wether the task belongs to the group or its descendants.
+  */
+  static bool InGroup(const Task& task, const TaskGroup* group);
+
+  /*!
+  * \brief Run a task and finish it.
+  */
+  void Run(Task& task);
+
+  /*!
+  * \brief Thread local worker information.
+  */
+  static const WorkStealingPool*& LocalPool() {
+    static thread_local const WorkStealingPool* pool = nullptr;
+    return pool;
+  }
+  static size_t& LocalId() {
+    static thread_local size_t id = 0;
+    return id;
+  }
+  static TaskGroup*& LocalGroup() {
+    static thread_local TaskGroup* group = nullptr;
+    return group;
+  }
+};
+
+/*!
+* \breif The constructor just launches some amount of workers
+*/
+inline WorkStealingPool::WorkStealingPool(size_t threads)
+    : stop(false) {
+  CHECK_GT(threads, 0);
+  for (size_t i = 0; i <= threads; ++i) {
+    deques.emplace_back(new TaskDeque());
+  }
+  for (size_t i = 0; i < threads; ++i) {
+    workers.emplace_back([this, i] {
+      LocalPool() = this;
+      LocalId() = i;
+      for (;;) {
+        Task task;
+        if (TryPop(i, nullptr, &task)) {
+          Run(task);
+          continue;
+        }
+        std::unique_lock<std::mutex> lock(this->sleep_mutex);
+        this->sleep_condition.wait(lock,
+          [this] { return this->stop || this->queued > 0; });
+        if (this->stop && this->queued == 0) {
+          return;
+        }
+      }
+    });
+  }
+}
+
+/*!
+* \breif Add new work item to the pool
+*/
+inline void WorkStealingPool::Spawn(TaskGroup* group,
+                                    std::function<void()> task) {
+  CHECK_NOTNULL(group);
+  // The first task links the group to the running task
+  if (group->pending++ == 0 && group != LocalGroup()) {
+    group->parent.store(LocalGroup(), std::memory_order_release);
+  }
+  TaskDeque& deque = *deques[WorkerId()];
+  {
+    std::unique_lock<std::mutex> lock(deque.mutex);
+    deque.tasks.emplace_back();
+    deque.tasks.back().func = std::move(task);
+    deque.tasks.back().group = group;
+  }
+  {
+    std::unique_lock<std::mutex> lock(sleep_mutex);
+    queued++;
+    spawned++;
+  }
+  sleep_condition.notify_one();
+  done_condition.notify_all();
+}
+
+/*!
+* \breif Help executing tasks until the group is finished
+*/
+inline void WorkStealingPool::Wait(TaskGroup* group) {
+  size_t id = WorkerId();
+  while (group->pending > 0) {
+    uint64 seen = spawned;
+    Task task;
+    if (TryPop(id, group, &task)) {
+      Run(task);
+      continue;
+    }
+    // Other workers are running the rest tasks of the group, and
+    // a finished or spawned task notifies under sleep_mutex
+    std::unique_lock<std::mutex> lock(sleep_mutex);
+    done_condition.wait(lock, [this, group, seen] { 
+      return group->pending == 0 || this->spawned != seen; 
+    });
+  }
+}
+
+/*!
+* \breif Id of current thread
+*/
+inline size_t WorkStealingPool::WorkerId() const {
+  return LocalPool() == this ? LocalId() : workers.size();
+}
+
+/*!
+* \breif Pop from own deque (LIFO) or steal from others (FIFO)
+*/
+inline bool WorkStealingPool::TryPop(size_t id, 
+                                     const TaskGroup* group, 
+                                     Task* task) {
+  if (queued == 0) {
+    return false;
+  }
+  size_t n = deques.size();
+  for (size_t k = 0; k < n; ++k) {
+    size_t victim = (id + k) % n;
+    TaskDeque& deque = *deques[victim];
+    std::unique_lock<std::mutex> lock(deque.mutex);
+    size_t len = deque.tasks.size();
+    for (size_t i = 0; i < len; ++i) {
+      // Own deque from the back, and others from the front
+      size_t pos = k == 0 ? len - 1 - i : i;
+      if (group != nullptr && !InGroup(deque.tasks[pos], group)) {
+        continue;
+      }
+      *task = std::move(deque.tasks[pos]);
+      deque.tasks.erase(deque.tasks.begin() + pos);
+      queued--;
+      return true;
+    }
+  }
+  return false;
+}
+
+/*!
+* \breif Walk up the groups of the task
+*/
+inline bool WorkStealingPool::InGroup(const Task& task, 
+                                      const TaskGroup* group) {
+  for (const TaskGroup* g = task.group; g != nullptr; 
+       g = g->parent.load(std::memory_order_acquire)) {
+    if (g == group) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/*!
+* \breif Run a task and notify the waiting threads
+*/
+inline void WorkStealingPool::Run(Task& task) {
+  TaskGroup* group = task.group;
+  TaskGroup* outer = LocalGroup();
+  LocalGroup() = group;
+  task.func();
+  LocalGroup() = outer;
+  {
+    std::unique_lock<std::mutex> lock(sleep_mutex);
+    group->pending--;
+  }
+  done_condition.notify_all();
+}
+
+/*!
+* \breif The destructor joins all threads
+*/
+inline WorkStealingPool::~WorkStealingPool() {
+  {
+    std::unique_lock<std::mutex> lock(sleep_mutex);
+    stop = true;
+  }
+  sleep_condition.notify_all();
+  for (std::thread &worker: workers) {
+    worker.join();
+  }
+}
+
+#endif  // XFOREST_BASE_WORK_STEALING_POOL_H_
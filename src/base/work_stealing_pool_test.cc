@@ -0,0 +1,92 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2018 by contributors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//------------------------------------------------------------------------------
+
+/*!
+*  Copyright (c) 2018 by Contributors
+* \file work_stealing_pool_test.cc
+* \brief This file tests work_stealing_pool.h file.
+*/
+#include "gtest/gtest.h"
+
+#include "src/base/work_stealing_pool.h"
+
+TEST(WorkStealingPoolTest, Sum_test) {
+  WorkStealingPool pool(4);
+  std::atomic_int sum(0);
+  TaskGroup group;
+  for (int i = 0; i < 100; ++i) {
+    pool.Spawn(&group, [&sum, i]() { sum += i; });
+  }
+  pool.Wait(&group);
+  EXPECT_EQ(sum, 4950);
+}
+
+// Spawn sub-tasks recursively and wait for them
+int Fib(WorkStealingPool* pool, int n) {
+  if (n < 2) {
+    return n;
+  }
+  int a = 0;
+  int b = 0;
+  TaskGroup group;
+  pool->Spawn(&group, [pool, n, &a]() { a = Fib(pool, n - 1); });
+  pool->Spawn(&group, [pool, n, &b]() { b = Fib(pool, n - 2); });
+  pool->Wait(&group);
+  return a + b;
+}
+
+TEST(WorkStealingPoolTest, Nested_test) {
+  WorkStealingPool pool(3);
+  EXPECT_EQ(Fib(&pool, 15), 610);
+  // Nested tasks from workers
+  std::atomic_int sum(0);
+  TaskGroup group;
+  for (int i = 0; i < 8; ++i) {
+    pool.Spawn(&group, [&pool, &sum]() { sum += Fib(&pool, 10); });
+  }
+  pool.Wait(&group);
+  EXPECT_EQ(sum, 8 * 55);
+}
+
+TEST(WorkStealingPoolTest, Group_test) {
+  WorkStealingPool pool(3);
+  std::atomic_int max_depth(0);
+  TaskGroup group;
+  for (int i = 0; i < 16; ++i) {
+    pool.Spawn(&group, [&]() {
+      // A task waiting for its sub-tasks does not run the
+      // other outer tasks on the same thread
+      static thread_local int depth = 0;
+      depth++;
+      if (depth > max_depth) {
+        max_depth = depth;
+      }
+      TaskGroup sub_group;
+      std::atomic_int sum(0);
+      for (int k = 0; k < 8; ++k) {
+        pool.Spawn(&sub_group, [&sum, k]() {
+          std::this_thread::sleep_for(std::chrono::microseconds(200));
+          sum += k;
+        });
+      }
+      pool.Wait(&sub_group);
+      EXPECT_EQ(sum, 28);
+      depth--;
+    });
+  }
+  pool.Wait(&group);
+  EXPECT_EQ(max_depth, 1);
+}
@@ -0,0 +1,52 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2018 by contributors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//------------------------------------------------------------------------------
+
+/*
+This file is the entry of the model compiler of xforest, which turns
+a trained forest into a standalone C++ source file:
+
+  xforest_codegen model_file source_file [prefix]
+
+and the source file can be compiled into the service, e.g.:
+
+  c++ -O3 -c source_file
+*/
+
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include "src/base/common.h"
+#include "src/base/file_util.h"
+#include "src/tree/codegen.h"
+#include "src/tree/forest.h"
+
+int main(int argc, char* argv[]) {
+  if (argc < 3 || argc > 4) {
+    printf("Usage: %s model_file source_file [prefix]\n", argv[0]);
+    return 1;
+  }
+  xforest::Forest forest;
+  forest.Load(argv[1]);
+  std::string code;
+  xforest::GenerateCode(forest, argc == 4 ? argv[3] : "", &code);
+  FILE* file = OpenFileOrDie(argv[2], "w");
+  CHECK_EQ(WriteDataToDisk(file, code.data(), code.size()), code.size());
+  Close(file);
+  printf("Compiled %zu trees to %s\n", forest.NumTree(), argv[2]);
+  return 0;
+}
@@ -101,15 +101,117 @@ struct HyperParam {
   */
   real_t min_impurity_split = 1e-7;
   /*!
+  * Wether the sampled rows (and labels) are physically reordered for each 
+  * node during training (default=false). The rows of a node are then stored
+  * contiguously, and the histogram kernels stream memory instead of gathering
+  * rows by index. This costs a copy of the sampled data per tree level and
+  * twice the memory of the sampled data, but gives much better cache behaviour
+  * on large datasets.
+  */
+  bool reorder_data = false;
+  /*!
+  * The distance (in rows) of software prefetching in the loops that gather
+  * rows by index (default=-1). 0 disables prefetching, and -1 means that the 
+  * distance is chosen by a calibration benchmark, which runs once per process
+  * for each number of feature and dataset size (relative to the last level
+  * cache).
+  */
+  int prefetch_distance = -1;
+  /*!
+  * The byte budget of the histograms kept for histogram subtraction in a tree
+  * (default=-1). The least recently used histograms are evicted when the budget
+  * is exceeded, and the nodes that need them build their histograms from data.
+  * -1 means unlimited.
+  */
+  int64 max_histogram_bytes = -1;
+  /*!
+  * \brief The order to grow a tree (default=breadth_first). Supported orders 
+  * are "breadth_first", "depth_first" and "hybrid". Breadth-first growing keeps
+  * the histograms of a whole level alive for histogram subtraction, while 
+  * depth-first growing finishes one sub-tree before its brother and only keeps
+  * O(max_depth) histograms alive. "hybrid" grows the nodes above hybrid_depth 
+  * breadth-first and the others depth-first. The trees are the same unless 
+  * max_leaf_nodes stops the growing.
+  */
+  std::string grow_policy = "breadth_first";
+  /*!
+  * \brief Nodes above this depth are grown breadth-first when 
+  * grow_policy = "hybrid" (default=6).
+  */
+  int hybrid_depth = 6;
+  /*!
   * Wether bootstrap samples are used when building trees (default=true).
   */
   bool bootstrap = true;
   /*!
+  * Wether to use out-of-bag samples to estimate the generalization error (default=false).
+  * The out-of-bag votes are accumulated as each tree finishes, and bootstrap must be true.
+  */
+  bool oob_score = false;
+  /*!
+  * The number of trees in a round of early stopping (default=-1). If n_iter_no_change > 0,
+  * trees are added in rounds, and the training stops when the out-of-bag error of a round
+  * is not lower than the last one by at least tol, and the trees of that round are dropped.
+  * -1 means disabled, and oob_score must be true if it is enabled.
+  */
+  int n_iter_no_change = -1;
+  /*!
+  * Tolerance of the out-of-bag error improvement for early stopping (default=1e-4).
+  */
+  real_t tol = 1e-4;
+  /*!
   * The number of jobs to run in parallel for both fit and predict (default=-1).
   * -1 means using all processors.
   */
   int n_jobs = -1;
   /*!
+  * The number of trees that are grown together and share one sweep over the
+  * dataset per level (default=1). A larger batch reads the dataset fewer times,
+  * but each tree in a batch is grown breadth-first and costs 6 bytes per row of
+  * the dataset for its row-to-node map, plus the histograms of two levels. A
+  * batch is grown by one thread (the batches are grown in parallel), without
+  * prefetching, so tree_batch_size > 1 requires grow_policy = "breadth_first",
+  * reorder_data = false, max_histogram_bytes = -1 and prefetch_distance <= 0.
+  */
+  int tree_batch_size = 1;
+  /*!
+  * The number of new rows a leaf node should observe between split attempts in online
+  * update (default=200).
+  */
+  int grace_period = 200;
+  /*!
+  * Allowed error (delta of the Hoeffding bound) of choosing a wrong split in online update
+  * (default=1e-7). A smaller value needs more rows to split a leaf node.
+  */
+  real_t split_confidence = 1e-7;
+  /*!
+  * Allowed error (delta of the Hoeffding bound) of replacing the label of a leaf node by the
+  * majority class of its new rows in online update (default=0.01). Until then, the leaf node
+  * keeps the label from the batch training or its parent. A wrong label is revisited with
+  * each mini-batch, so it can be much looser than split_confidence.
+  */
+  real_t label_confidence = 0.01;
+  /*!
+  * In online update, a leaf node is split when the Hoeffding bound is less than
+  * tie_threshold, even if the best two splits are too close to tell apart (default=0.05).
+  */
+  real_t tie_threshold = 0.05;
+  /*!
+  * The byte budget of the leaf histograms kept by online update in a tree (default=256MB).
+  * Each leaf node reached by new rows keeps a histogram of max_features * (max_bin + 1) *
+  * num_class counters of 4 bytes until it is split, e.g., 30MB for 3000 features, 256 bins
+  * and 10 classes. When the budget is exceeded, the histogram of the leaf node that has
+  * observed the fewest new rows is dropped, and that leaf node starts over. -1 means
+  * unlimited.
+  */
+  int64 max_online_histogram_bytes = 256ll << 20;
+  /*!
+  * When set to true, reuse the trees of the last training (or the loaded model), and only
+  * add more trees to the forest until there are n_estimators trees (default=false). The
+  * dataset must be binned by the bin boundaries of the existing model.
+  */
+  bool warm_start = false;
+  /*!
   * \breif random_state is the seed used by the random number generator (default=1231).
   */
   int random_state = 1231;
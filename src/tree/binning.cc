@@ -0,0 +1,132 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2018 by contributors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//------------------------------------------------------------------------------
+
+/*
+This file is the implementation of binning functions.
+*/
+
+#include "src/tree/binning.h"
+
+#include "src/base/file_util.h"
+
+namespace xforest {
+
+static const uint32 kBinnedDataMagic = 0x58464244;  // "XFBD"
+
+// Find max-min of each feature
+void FindMaxMin(const real_t* X,
+                const index_t num_feat,
+                const index_t data_size,
+                const uint8 max_bin,
+                std::vector<MaxMin>* max_min) {
+  CHECK_NOTNULL(X);
+  CHECK_GT(max_bin, 0);
+  max_min->assign(num_feat, MaxMin());
+  for (index_t i = 0; i < data_size; ++i) {
+    const real_t* row = X + (uint64)i * num_feat;
+    for (index_t j = 0; j < num_feat; ++j) {
+      MaxMin& mm = (*max_min)[j];
+      mm.max_feat = std::max(mm.max_feat, row[j]);
+      mm.min_feat = std::min(mm.min_feat, row[j]);
+    }
+  }
+  for (MaxMin& mm : *max_min) {
+    mm.gap = mm.max_feat > mm.min_feat ? 
+             (mm.max_feat - mm.min_feat) / max_bin : 0;
+  }
+}
+
+// Map raw dataset to bin values
+void BinData(const real_t* X,
+             const index_t num_feat,
+             const index_t data_size,
+             const uint8 max_bin,
+             const std::vector<MaxMin>& max_min,
+             uint8* out) {
+  CHECK_NOTNULL(X);
+  CHECK_NOTNULL(out);
+  CHECK_EQ(max_min.size(), num_feat);
+  for (index_t i = 0; i < data_size; ++i) {
+    const real_t* row = X + (uint64)i * num_feat;
+    uint8* bin_row = out + (uint64)i * num_feat;
+    for (index_t j = 0; j < num_feat; ++j) {
+      bin_row[j] = BinValue(row[j], max_min[j], max_bin);
+    }
+  }
+}
+
+// Save binned dataset to file
+void SaveBinnedData(const std::string& filename,
+                    const std::vector<uint8>& X,
+                    const std::vector<real_t>& Y,
+                    const index_t num_feat,
+                    const uint8 num_class,
+                    const uint8 max_bin,
+                    const std::vector<MaxMin>& max_min) {
+  index_t data_size = Y.size();
+  CHECK_GT(data_size, 0);
+  CHECK_EQ(X.size(), (uint64)num_feat * data_size);
+  CHECK_EQ(max_min.size(), num_feat);
+  FILE* file = OpenFileOrDie(filename.c_str(), "w");
+  WriteDataToDisk(file, (const char*)&kBinnedDataMagic, sizeof(uint32));
+  WriteDataToDisk(file, (const char*)&num_feat, sizeof(index_t));
+  WriteDataToDisk(file, (const char*)&data_size, sizeof(index_t));
+  WriteDataToDisk(file, (const char*)&num_class, sizeof(uint8));
+  WriteDataToDisk(file, (const char*)&max_bin, sizeof(uint8));
+  WriteDataToDisk(file, (const char*)max_min.data(), 
+                  sizeof(MaxMin) * num_feat);
+  WriteDataToDisk(file, (const char*)X.data(), X.size());
+  WriteDataToDisk(file, (const char*)Y.data(), sizeof(real_t) * data_size);
+  Close(file);
+}
+
+// Load binned dataset from file
+index_t LoadBinnedData(const std::string& filename,
+                       std::vector<uint8>* X,
+                       std::vector<real_t>* Y,
+                       index_t* num_feat,
+                       uint8* num_class,
+                       uint8* max_bin,
+                       std::vector<MaxMin>* max_min) {
+  FILE* file = OpenFileOrDie(filename.c_str(), "r");
+  uint32 magic = 0;
+  index_t data_size = 0;
+  CHECK_EQ(ReadDataFromDisk(file, (char*)&magic, sizeof(uint32)),
+           sizeof(uint32));
+  if (magic != kBinnedDataMagic) {
+    LOG(FATAL) << "Not a binned data file: " << filename;
+  }
+  CHECK_EQ(ReadDataFromDisk(file, (char*)num_feat, sizeof(index_t)),
+           sizeof(index_t));
+  CHECK_EQ(ReadDataFromDisk(file, (char*)&data_size, sizeof(index_t)),
+           sizeof(index_t));
+  CHECK_EQ(ReadDataFromDisk(file, (char*)num_class, sizeof(uint8)),
+           sizeof(uint8));
+  CHECK_EQ(ReadDataFromDisk(file, (char*)max_bin, sizeof(uint8)),
+           sizeof(uint8));
+  max_min->resize(*num_feat);
+  X->resize((uint64)*num_feat * data_size);
+  Y->resize(data_size);
+  uint64 len = sizeof(MaxMin) * (*num_feat);
+  CHECK_EQ(ReadDataFromDisk(file, (char*)max_min->data(), len), len);
+  CHECK_EQ(ReadDataFromDisk(file, (char*)X->data(), X->size()), X->size());
+  len = sizeof(real_t) * data_size;
+  CHECK_EQ(ReadDataFromDisk(file, (char*)Y->data(), len), len);
+  Close(file);
+  return data_size;
+}
+
+}  // namespace xforest
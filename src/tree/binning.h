@@ -0,0 +1,120 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2018 by contributors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//------------------------------------------------------------------------------
+
+/*!
+*  Copyright (c) 2018 by Contributors
+* \file binning.h
+* \brief This file maps feature values to 8-bit bin values, and
+* caches the binned dataset on disk.
+*/
+#ifndef XFOREST_TREE_BINNING_H_
+#define XFOREST_TREE_BINNING_H_
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "src/base/common.h"
+
+namespace xforest {
+
+/*!
+* \brief Find maximal and minimal value for each feature.
+* For Histogram decision tree, we need to map original feature
+* value to 8-bit bin value, hence here we need to find the
+* of the maximal and minimal value for each feature.
+*/
+struct MaxMin {
+  real_t gap = 0.0;
+  // Note that kFloatMin is the minimal positive value
+  real_t max_feat = -kFloatMax;
+  real_t min_feat = kFloatMax;
+};
+
+/*!
+* \brief Find the maximal and minimal value of each feature, and the
+* gap of equal-width bins so that values are mapped to [0, max_bin].
+* \param X pointer of raw dataset (row-major)
+* \param num_feat number of feature
+* \param data_size size of dataset
+* \param max_bin maximal bin value
+* \param max_min max-min of each feature
+*/
+void FindMaxMin(const real_t* X,
+                const index_t num_feat,
+                const index_t data_size,
+                const uint8 max_bin,
+                std::vector<MaxMin>* max_min);
+
+/*!
+* \brief Map a feature value to bin value. Values out of the range 
+* of max_min are mapped to the first or the last bin.
+*/
+inline uint8 BinValue(real_t val, const MaxMin& max_min, uint8 max_bin) {
+  if (max_min.gap <= 0) {
+    return 0;
+  }
+  real_t bin = (val - max_min.min_feat) / max_min.gap;
+  if (!(bin > 0)) {
+    return 0;
+  }
+  return bin >= max_bin ? max_bin : (uint8)bin;
+}
+
+/*!
+* \brief Map a raw dataset to bin values by max_min.
+* \param X pointer of raw dataset (row-major)
+* \param num_feat number of feature
+* \param data_size size of dataset
+* \param max_bin maximal bin value
+* \param max_min max-min of each feature
+* \param out binned dataset (num_feat * data_size)
+*/
+void BinData(const real_t* X,
+             const index_t num_feat,
+             const index_t data_size,
+             const uint8 max_bin,
+             const std::vector<MaxMin>& max_min,
+             uint8* out);
+
+/*!
+* \brief Save binned dataset, label, number of classification and bin
+* boundaries to a cache file, so that later training (e.g., warm start)
+* can reuse them directly.
+*/
+void SaveBinnedData(const std::string& filename,
+                    const std::vector<uint8>& X,
+                    const std::vector<real_t>& Y,
+                    const index_t num_feat,
+                    const uint8 num_class,
+                    const uint8 max_bin,
+                    const std::vector<MaxMin>& max_min);
+
+/*!
+* \brief Load binned dataset from a cache file.
+* \return size of dataset
+*/
+index_t LoadBinnedData(const std::string& filename,
+                       std::vector<uint8>* X,
+                       std::vector<real_t>* Y,
+                       index_t* num_feat,
+                       uint8* num_class,
+                       uint8* max_bin,
+                       std::vector<MaxMin>* max_min);
+
+}  // namespace xforest
+
+#endif  // XFOREST_TREE_BINNING_H_
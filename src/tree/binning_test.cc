@@ -0,0 +1,93 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2018 by contributors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//------------------------------------------------------------------------------
+
+/*!
+*  Copyright (c) 2018 by Contributors
+* \file binning_test.cc
+* \brief This file tests binning.h file.
+*/
+#include "gtest/gtest.h"
+
+#include <vector>
+
+#include "src/base/common.h"
+#include "src/base/file_util.h"
+#include "src/tree/binning.h"
+
+namespace xforest {
+
+TEST(BinningTest, Bin_data) {
+  // 3 rows and 2 features, and the second feature is constant
+  std::vector<real_t> X = { -1.0, 5.0, 
+                             0.0, 5.0,
+                             3.0, 5.0 };
+  std::vector<MaxMin> max_min;
+  FindMaxMin(X.data(), 2, 3, 4, &max_min);
+  EXPECT_FLOAT_EQ(max_min[0].min_feat, -1.0);
+  EXPECT_FLOAT_EQ(max_min[0].max_feat, 3.0);
+  EXPECT_FLOAT_EQ(max_min[0].gap, 1.0);
+  EXPECT_FLOAT_EQ(max_min[1].gap, 0.0);
+  std::vector<uint8> out(6);
+  BinData(X.data(), 2, 3, 4, max_min, out.data());
+  EXPECT_EQ(out[0], 0);
+  EXPECT_EQ(out[2], 1);
+  EXPECT_EQ(out[4], 4);
+  EXPECT_EQ(out[1], 0);
+  // Out of range
+  EXPECT_EQ(BinValue(-10.0, max_min[0], 4), 0);
+  EXPECT_EQ(BinValue(10.0, max_min[0], 4), 4);
+}
+
+TEST(BinningTest, Negative_feature) {
+  std::vector<real_t> X = { -3.0, -1.0, -2.0 };
+  std::vector<MaxMin> max_min;
+  FindMaxMin(X.data(), 1, 3, 2, &max_min);
+  EXPECT_FLOAT_EQ(max_min[0].max_feat, -1.0);
+  EXPECT_FLOAT_EQ(max_min[0].min_feat, -3.0);
+  EXPECT_EQ(BinValue(-2.0, max_min[0], 2), 1);
+}
+
+TEST(BinningTest, Save_and_load) {
+  std::vector<real_t> X = { 1.0, 2.0, 3.0, 4.0 };
+  std::vector<real_t> Y = { 0, 1 };
+  std::vector<MaxMin> max_min;
+  FindMaxMin(X.data(), 2, 2, 255, &max_min);
+  std::vector<uint8> X_bin(4);
+  BinData(X.data(), 2, 2, 255, max_min, X_bin.data());
+  SaveBinnedData("/tmp/xforest_test.bin", X_bin, Y, 2, 3, 255, max_min);
+  std::vector<uint8> new_X;
+  std::vector<real_t> new_Y;
+  std::vector<MaxMin> new_max_min;
+  index_t num_feat = 0;
+  uint8 num_class = 0;
+  uint8 max_bin = 0;
+  index_t data_size = LoadBinnedData("/tmp/xforest_test.bin", 
+    &new_X, &new_Y, &num_feat, &num_class, &max_bin, &new_max_min);
+  EXPECT_EQ(data_size, 2);
+  EXPECT_EQ(num_feat, 2);
+  // Class 2 has no rows
+  EXPECT_EQ(num_class, 3);
+  EXPECT_EQ(max_bin, 255);
+  EXPECT_EQ(new_X, X_bin);
+  EXPECT_EQ(new_Y, Y);
+  for (index_t j = 0; j < num_feat; ++j) {
+    EXPECT_EQ(new_max_min[j].gap, max_min[j].gap);
+    EXPECT_EQ(new_max_min[j].min_feat, max_min[j].min_feat);
+  }
+  RemoveFile("/tmp/xforest_test.bin");
+}
+
+}  // namespace xforest
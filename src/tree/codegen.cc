@@ -0,0 +1,90 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2018 by contributors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//------------------------------------------------------------------------------
+
+/*
+This file is the implementation of the code generator of forest.
+*/
+
+#include "src/tree/codegen.h"
+
+#include "src/base/stringprintf.h"
+
+namespace xforest {
+
+// Emit a sub-tree as nested if/else
+static void EmitNode(const DTNode* node,
+                     uint8 num_class,
+                     int depth,
+                     std::string* code) {
+  std::string indent(depth * 2, ' ');
+  if (node->IsLeaf()) {
+    int label = (int)node->leaf_val;
+    CHECK_EQ((real_t)label, node->leaf_val);
+    CHECK_GE(label, 0);
+    CHECK_LT(label, num_class);
+    StringAppendF(code, "%sreturn %d;\n", indent.c_str(), label);
+    return;
+  }
+  StringAppendF(code, "%sif (x[%u] <= %u) {\n", indent.c_str(),
+                node->BestFeatID(), (uint32)node->BestBinVal());
+  EmitNode(node->LeftChild(), num_class, depth + 1, code);
+  StringAppendF(code, "%s} else {\n", indent.c_str());
+  EmitNode(node->RightChild(), num_class, depth + 1, code);
+  StringAppendF(code, "%s}\n", indent.c_str());
+}
+
+// Generate C++ source code of forest
+void GenerateCode(const Forest& forest,
+                  const std::string& prefix,
+                  std::string* code) {
+  CHECK_NOTNULL(code);
+  CHECK_GT(forest.NumTree(), 0);
+  uint8 num_class = forest.NumClass();
+  CHECK_GT(num_class, 0);
+  code->clear();
+  StringAppendF(code, "// Generated by xforest from a forest of %zu "
+                "trees. Do not edit.\n", forest.NumTree());
+  code->append("#include <stdint.h>\n\n");
+  code->append("namespace {\n\n");
+  for (size_t t = 0; t < forest.NumTree(); ++t) {
+    const DTNode* root = forest.Tree(t)->Root();
+    CHECK_NOTNULL(root);
+    StringAppendF(code, "int tree_%zu(const uint8_t* x) {\n", t);
+    EmitNode(root, num_class, 1, code);
+    code->append("}\n\n");
+  }
+  code->append("}  // namespace\n\n");
+  // Majority vote, and ties go to the smaller label as Forest::Predict()
+  StringAppendF(code, "extern \"C\" int %spredict(const uint8_t* x) {\n",
+                prefix.c_str());
+  StringAppendF(code, "  int votes[%d] = { 0 };\n", (int)num_class);
+  for (size_t t = 0; t < forest.NumTree(); ++t) {
+    StringAppendF(code, "  votes[tree_%zu(x)]++;\n", t);
+  }
+  code->append("  int best = 0;\n");
+  StringAppendF(code, "  for (int k = 1; k < %d; ++k) {\n", (int)num_class);
+  code->append("    if (votes[k] > votes[best]) {\n");
+  code->append("      best = k;\n");
+  code->append("    }\n");
+  code->append("  }\n");
+  code->append("  return best;\n");
+  code->append("}\n\n");
+  StringAppendF(code, "extern \"C\" int %snum_feature() {\n", prefix.c_str());
+  StringAppendF(code, "  return %u;\n", forest.NumFeat());
+  code->append("}\n");
+}
+
+}  // namespace xforest
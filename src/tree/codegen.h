@@ -0,0 +1,56 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2018 by contributors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//------------------------------------------------------------------------------
+
+/*!
+*  Copyright (c) 2018 by Contributors
+* \file codegen.h
+* \brief This file compiles a trained forest to C++ source code.
+*/
+#ifndef XFOREST_TREE_CODEGEN_H_
+#define XFOREST_TREE_CODEGEN_H_
+
+#include <string>
+
+#include "src/base/common.h"
+#include "src/tree/forest.h"
+
+namespace xforest {
+
+/*!
+* \brief Generate a standalone C++ source file of the forest, which has
+* no dependency on xforest. Each tree becomes a function of nested
+* if/else statements with the feature ids and split bins inlined, and
+* the file exports the following C functions:
+*
+*   // Label of a binned row by majority vote
+*   int <prefix>predict(const uint8_t* x);
+*   // Number of feature of a row
+*   int <prefix>num_feature();
+*
+* Compiled with -O3, the model is a part of the code, and scoring does
+* not load any model data. The rows must be binned by the bin boundaries
+* of the model. The prefix allows several models in one binary.
+* \param forest trained (or loaded) forest of classification trees
+* \param prefix prefix of the exported functions
+* \param code generated source code
+*/
+void GenerateCode(const Forest& forest,
+                  const std::string& prefix,
+                  std::string* code);
+
+}  // namespace xforest
+
+#endif  // XFOREST_TREE_CODEGEN_H_
@@ -0,0 +1,95 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2018 by contributors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//------------------------------------------------------------------------------
+
+/*!
+*  Copyright (c) 2018 by Contributors
+* \file codegen_test.cc
+* \brief This file tests codegen.h file.
+*/
+#include "gtest/gtest.h"
+
+#include <dlfcn.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "src/base/common.h"
+#include "src/base/file_util.h"
+#include "src/base/stringprintf.h"
+#include "src/tree/codegen.h"
+#include "src/tree/test_util.h"
+
+namespace xforest {
+
+static const index_t kNumFeat = 10;
+static const index_t kDataSize = 3000;
+
+TEST(CodegenTest, Generate_code) {
+  std::vector<uint8> X;
+  std::vector<real_t> Y;
+  GenData(kNumFeat, kDataSize, X, Y);
+  HyperParam param;
+  param.max_bin = kMaxBin;
+  param.n_estimators = 10;
+  param.max_features = 5;
+  param.max_depth = 8;
+  param.n_jobs = 1;
+  Forest forest;
+  forest.Initialize(X.data(), Y.data(), 3, kNumFeat, kDataSize, param);
+  forest.Train();
+  std::string code;
+  GenerateCode(forest, "model_", &code);
+  EXPECT_NE(code.find("extern \"C\" int model_predict("), std::string::npos);
+  EXPECT_NE(code.find("int tree_9("), std::string::npos);
+  EXPECT_EQ(code.find("int tree_10("), std::string::npos);
+  // Compile the code and compare the predictions, which are
+  // skipped only if there is no C++ compiler
+  if (system("c++ --version > /dev/null 2>&1") != 0) {
+    LOG(WARNING) << "Skip the compiled model: no C++ compiler";
+    return;
+  }
+  // Files of this process, which are removed as soon as they are used
+  std::string src_file = StringPrintf("/tmp/xforest_codegen_test.%d.cc",
+                                      (int)getpid());
+  std::string lib_file = StringPrintf("/tmp/xforest_codegen_test.%d.so",
+                                      (int)getpid());
+  FILE* file = OpenFileOrDie(src_file.c_str(), "w");
+  WriteDataToDisk(file, code.data(), code.size());
+  Close(file);
+  std::string cmd = "c++ -O1 -shared -fPIC -o " + lib_file + " " + src_file;
+  int ret = system(cmd.c_str());
+  RemoveFile(src_file.c_str());
+  ASSERT_EQ(ret, 0);
+  // The loaded library stays mapped after its file is removed
+  void* lib = dlopen(lib_file.c_str(), RTLD_NOW);
+  RemoveFile(lib_file.c_str());
+  ASSERT_TRUE(lib != nullptr);
+  typedef int (*PredictFunc)(const uint8*);
+  typedef int (*NumFeatFunc)();
+  PredictFunc predict = (PredictFunc)dlsym(lib, "model_predict");
+  NumFeatFunc num_feature = (NumFeatFunc)dlsym(lib, "model_num_feature");
+  ASSERT_TRUE(predict != nullptr);
+  ASSERT_TRUE(num_feature != nullptr);
+  EXPECT_EQ(num_feature(), kNumFeat);
+  for (index_t i = 0; i < kDataSize; ++i) {
+    const uint8* x = X.data() + i * kNumFeat;
+    EXPECT_EQ(predict(x), forest.Predict(x));
+  }
+  dlclose(lib);
+}
+
+}  // namespace xforest
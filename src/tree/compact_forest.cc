@@ -0,0 +1,224 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2018 by contributors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//------------------------------------------------------------------------------
+
+/*
+This file is the implementation of CompactForest class.
+*/
+
+#include "src/tree/compact_forest.h"
+
+#include <algorithm>
+
+#include "src/base/file_util.h"
+
+namespace xforest {
+
+static const uint32 kCompactMagic = 0x58464346;  // "XFCF"
+
+// Decode a varint of at most 5 bytes before end
+static bool ReadBoundedVarint(const uint8** p, 
+                              const uint8* end, 
+                              uint32* val) {
+  *val = 0;
+  for (int shift = 0; shift < 35; shift += 7) {
+    if (*p == end) {
+      return false;
+    }
+    uint8 byte = *(*p)++;
+    // The 5th byte only holds the highest 4 bits
+    if (shift == 28 && byte > 0x0F) {
+      return false;
+    }
+    *val |= (uint32)(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Encode trees
+void CompactForest::Build(const std::vector<DTree*>& trees, 
+                          uint8 num_class, 
+                          index_t num_feat) {
+  CHECK(!trees.empty());
+  CHECK_GT(num_class, 0);
+  num_class_ = num_class;
+  num_feat_ = num_feat;
+  roots_.clear();
+  bytes_.clear();
+  std::map<NodeKey, uint32> nodes;
+  for (const DTree* tree : trees) {
+    CHECK_NOTNULL(tree->Root());
+    roots_.push_back(Encode(tree->Root(), &nodes));
+  }
+  std::vector<uint8>(bytes_).swap(bytes_);
+}
+
+// Append a sub-tree in post-order
+uint32 CompactForest::Encode(const DTNode* node, 
+                             std::map<NodeKey, uint32>* nodes) {
+  if (node->IsLeaf()) {
+    uint32 y = (uint32)node->leaf_val;
+    CHECK_EQ((real_t)y, node->leaf_val);
+    CHECK_LT(y, num_class_);
+    return (y << 1) | 1;
+  }
+  uint32 left = Encode(node->LeftChild(), nodes);
+  uint32 right = Encode(node->RightChild(), nodes);
+  // Both sides reach the same leaf nodes
+  if (left == right) {
+    return left;
+  }
+  NodeKey key(node->BestFeatID(), node->BestBinVal(), left, right);
+  auto iter = nodes->find(key);
+  if (iter != nodes->end()) {
+    return iter->second;
+  }
+  uint32 pos = bytes_.size();
+  CHECK_LT(pos, kMaxByte);
+  WriteVarint(node->BestFeatID());
+  bytes_.push_back(node->BestBinVal());
+  // Children are written before, at smaller positions
+  for (uint32 child : {left, right}) {
+    WriteVarint((child & 1) ? child : (pos - (child >> 1)) << 1);
+  }
+  uint32 ref = pos << 1;
+  nodes->emplace(key, ref);
+  return ref;
+}
+
+// Append 7 bits per byte
+void CompactForest::WriteVarint(uint32 val) {
+  while (val >= 0x80) {
+    bytes_.push_back((uint8)(val | 0x80));
+    val >>= 7;
+  }
+  bytes_.push_back((uint8)val);
+}
+
+// Majority vote
+real_t CompactForest::Predict(const uint8* x) const {
+  static thread_local std::vector<index_t> votes;
+  votes.assign(num_class_, 0);
+  for (uint32 root : roots_) {
+    votes[GetLeaf(root, x)]++;
+  }
+  return (real_t)std::distance(votes.begin(),
+    std::max_element(votes.begin(), votes.end()));
+}
+
+// Save to file
+void CompactForest::Save(const std::string& filename) const {
+  CHECK(!roots_.empty());
+  FILE* file = OpenFileOrDie(filename.c_str(), "w");
+  index_t n_tree = roots_.size();
+  uint64 n_byte = bytes_.size();
+  WriteDataToDisk(file, (const char*)&kCompactMagic, sizeof(uint32));
+  WriteDataToDisk(file, (const char*)&num_class_, sizeof(uint8));
+  WriteDataToDisk(file, (const char*)&num_feat_, sizeof(index_t));
+  WriteDataToDisk(file, (const char*)&n_tree, sizeof(index_t));
+  WriteDataToDisk(file, (const char*)roots_.data(), 
+                  sizeof(uint32) * n_tree);
+  WriteDataToDisk(file, (const char*)&n_byte, sizeof(uint64));
+  if (n_byte > 0) {
+    WriteDataToDisk(file, (const char*)bytes_.data(), n_byte);
+  }
+  Close(file);
+}
+
+// Load from file
+void CompactForest::Load(const std::string& filename) {
+  FILE* file = OpenFileOrDie(filename.c_str(), "r");
+  uint32 magic = 0;
+  CHECK_EQ(ReadDataFromDisk(file, (char*)&magic, sizeof(uint32)),
+           sizeof(uint32));
+  if (magic != kCompactMagic) {
+    LOG(FATAL) << "Not a compact forest file: " << filename;
+  }
+  index_t n_tree = 0;
+  uint64 n_byte = 0;
+  CHECK_EQ(ReadDataFromDisk(file, (char*)&num_class_, sizeof(uint8)),
+           sizeof(uint8));
+  CHECK_EQ(ReadDataFromDisk(file, (char*)&num_feat_, sizeof(index_t)),
+           sizeof(index_t));
+  CHECK_EQ(ReadDataFromDisk(file, (char*)&n_tree, sizeof(index_t)),
+           sizeof(index_t));
+  roots_.resize(n_tree);
+  uint64 len = sizeof(uint32) * n_tree;
+  CHECK_EQ(ReadDataFromDisk(file, (char*)roots_.data(), len), len);
+  CHECK_EQ(ReadDataFromDisk(file, (char*)&n_byte, sizeof(uint64)), 
+           sizeof(uint64));
+  CHECK_LE(n_byte, kMaxByte);
+  bytes_.resize(n_byte);
+  if (n_byte > 0) {
+    CHECK_EQ(ReadDataFromDisk(file, (char*)bytes_.data(), n_byte), n_byte);
+  }
+  Close(file);
+  CHECK_GT(num_class_, 0);
+  CheckBytes();
+}
+
+// Walk all split nodes
+void CompactForest::CheckBytes() const {
+  const uint8* begin = bytes_.data();
+  const uint8* end = begin + bytes_.size();
+  std::vector<bool> is_node(bytes_.size(), false);
+  // Leaf node or a node before pos
+  auto check_ref = [&](uint32 ref, uint32 pos) {
+    if (ref & 1) {
+      if ((ref >> 1) >= num_class_) {
+        LOG(FATAL) << "Leaf class out of range: " << (ref >> 1);
+      }
+      return;
+    }
+    uint32 distance = ref >> 1;
+    if (distance == 0 || distance > pos || !is_node[pos - distance]) {
+      LOG(FATAL) << "Bad child reference " << distance 
+                 << " at byte " << pos;
+    }
+  };
+  const uint8* p = begin;
+  while (p < end) {
+    uint32 pos = p - begin;
+    is_node[pos] = true;
+    uint32 feat = 0;
+    uint32 left = 0;
+    uint32 right = 0;
+    // Feature id, bin value and two children
+    if (!ReadBoundedVarint(&p, end, &feat) || p++ == end ||
+        !ReadBoundedVarint(&p, end, &left) ||
+        !ReadBoundedVarint(&p, end, &right)) {
+      LOG(FATAL) << "Malformed node at byte " << pos;
+    }
+    if (feat >= num_feat_) {
+      LOG(FATAL) << "Feature id out of range: " << feat 
+                 << " at byte " << pos;
+    }
+    check_ref(left, pos);
+    check_ref(right, pos);
+  }
+  // The distance of a root is its position
+  for (uint32 root : roots_) {
+    if (root & 1) {
+      check_ref(root, 0);
+    } else if ((root >> 1) >= bytes_.size() || !is_node[root >> 1]) {
+      LOG(FATAL) << "Bad root reference " << (root >> 1);
+    }
+  }
+}
+
+}  // namespace xforest
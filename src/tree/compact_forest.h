@@ -0,0 +1,203 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2018 by contributors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//------------------------------------------------------------------------------
+
+/*!
+*  Copyright (c) 2018 by Contributors
+* \file compact_forest.h
+* \brief This file defines the CompactForest class, which is a
+* compressed inference-only encoding of a forest.
+*/
+#ifndef XFOREST_TREE_COMPACT_FOREST_H_
+#define XFOREST_TREE_COMPACT_FOREST_H_
+
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "src/base/common.h"
+#include "src/tree/dtree.h"
+
+namespace xforest {
+
+/*!
+* \brief CompactForest encodes the trees of a classification forest into
+* one byte array, and predicts from it directly. A split node takes a few
+* bytes: the varint of its feature id, its split bin value, and the
+* varint references of its two children. A reference is either a leaf,
+* i.e., (class << 1) | 1, so that leaf nodes take no bytes at all, or a
+* sub-tree, i.e., (distance << 1), where the distance is the backward
+* offset of the child from its parent in the array. The sub-trees are
+* written in post-order and hash-consed: a sub-tree identical to one
+* written before (of any tree) is shared instead of written again, and
+* a split node whose children are the same is replaced by its child.
+* Basic usage:
+*
+*   CompactForest compact;
+*   compact.Build(trees, num_class, num_feat);
+*   real_t y = compact.Predict(x);
+*   compact.Save(filename);
+*   ...
+*   CompactForest model;
+*   model.Load(filename);
+*   real_t y = model.Predict(x);
+*
+* The trees are copied, so they can be deleted afterwards. The leaf
+* values of the trees must be class ids less than num_class.
+*/
+class CompactForest {
+ public:
+  /*!
+  * \brief Constructor and Destructor
+  */
+  CompactForest() { }
+  ~CompactForest() { }
+
+  /*! \brief Maximal size of the byte array */
+  static const uint32 kMaxByte = 1u << 31;
+
+  /*!
+  * \brief Encode the trees.
+  * \param trees trained (or deserilized) trees
+  * \param num_class number of classification
+  * \param num_feat number of feature
+  */
+  void Build(const std::vector<DTree*>& trees, 
+             uint8 num_class, 
+             index_t num_feat);
+
+  /*!
+  * \brief Given data x, predict label y by majority vote.
+  * \param x pointer of data example
+  * \return predicted label y
+  */
+  real_t Predict(const uint8* x) const;
+
+  /*!
+  * \brief Class of the leaf node of data x in the tree of root ref.
+  */
+  inline uint8 GetLeaf(uint32 ref, const uint8* x) const {
+    const uint8* data = bytes_.data();
+    while (!(ref & 1)) {
+      uint32 pos = ref >> 1;
+      const uint8* p = data + pos;
+      index_t feat = ReadVarint(&p);
+      uint8 bin = *p++;
+      uint32 child = ReadVarint(&p);
+      if (x[feat] > bin) {
+        child = ReadVarint(&p);
+      }
+      ref = (child & 1) ? child : (pos - (child >> 1)) << 1;
+    }
+    return ref >> 1;
+  }
+
+  /*!
+  * \brief Decode a varint, and move p to the next byte.
+  */
+  static inline uint32 ReadVarint(const uint8** p) {
+    uint32 val = 0;
+    for (int shift = 0; ; shift += 7) {
+      uint8 byte = *(*p)++;
+      val |= (uint32)(byte & 0x7F) << shift;
+      if (!(byte & 0x80)) {
+        return val;
+      }
+    }
+  }
+
+  /*!
+  * \brief Save the encoded forest to file.
+  */
+  void Save(const std::string& filename) const;
+
+  /*!
+  * \brief Load the encoded forest from file. All of the split nodes
+  * are checked, so a corrupted file fails here instead of reading out
+  * of bounds (or looping) in Predict().
+  */
+  void Load(const std::string& filename);
+
+  /*!
+  * \brief Number of trees.
+  */
+  inline size_t NumTree() const {
+    return roots_.size();
+  }
+
+  /*!
+  * \brief Number of classification.
+  */
+  inline uint8 NumClass() const {
+    return num_class_;
+  }
+
+  /*!
+  * \brief Number of feature.
+  */
+  inline index_t NumFeat() const {
+    return num_feat_;
+  }
+
+  /*!
+  * \brief Number of bytes of the encoded split nodes.
+  */
+  inline size_t NumByte() const {
+    return bytes_.size();
+  }
+
+ protected:
+  /*! \brief Number of classification */
+  uint8 num_class_ = 0;
+  /*! \brief Number of feature */
+  index_t num_feat_ = 0;
+  /*! \brief Reference of the root of each tree, where the
+   * distance of a sub-tree is its offset from 0 */
+  std::vector<uint32> roots_;
+  /*! \brief Encoded split nodes */
+  std::vector<uint8> bytes_;
+
+  /*! \brief Feature id, bin value and children of a split node */
+  typedef std::tuple<index_t, uint8, uint32, uint32> NodeKey;
+
+  /*!
+  * \brief Encode a sub-tree in post-order, unless it is written before.
+  * \param node root of the sub-tree
+  * \param nodes written split nodes and their references
+  * \return reference of the sub-tree
+  */
+  uint32 Encode(const DTNode* node, std::map<NodeKey, uint32>* nodes);
+
+  /*!
+  * \brief Append a varint.
+  */
+  void WriteVarint(uint32 val);
+
+  /*!
+  * \brief Check that the split nodes are a sequence of well-formed
+  * nodes: the varints end within 5 bytes and the array, the feature
+  * ids are less than num_feat, the classes are less than num_class,
+  * and each child is the start of a node before its parent.
+  */
+  void CheckBytes() const;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(CompactForest);
+};
+
+}  // namespace xforest
+
+#endif  // XFOREST_TREE_COMPACT_FOREST_H_
@@ -0,0 +1,151 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2018 by contributors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//------------------------------------------------------------------------------
+
+/*!
+*  Copyright (c) 2018 by Contributors
+* \file compact_forest_test.cc
+* \brief This file tests compact_forest.h file.
+*/
+#include "gtest/gtest.h"
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "src/base/common.h"
+#include "src/base/file_util.h"
+#include "src/base/stl-util.h"
+#include "src/tree/compact_forest.h"
+#include "src/tree/flat_tree.h"
+#include "src/tree/test_util.h"
+
+namespace xforest {
+
+static const index_t kNumFeat = 8;
+static const index_t kDataSize = 2000;
+static const index_t kNumTree = 16;
+
+TEST(CompactForestTest, Predict) {
+  std::vector<uint8> X;
+  std::vector<real_t> Y;
+  GenData(kNumFeat, kDataSize, X, Y);
+  std::vector<DTree*> trees;
+  BuildTrees(X, Y, kNumFeat, kNumTree, 1000, &trees);
+  CompactForest compact;
+  compact.Build(trees, 3, kNumFeat);
+  EXPECT_EQ(compact.NumTree(), kNumTree);
+  for (index_t i = 0; i < kDataSize; ++i) {
+    const uint8* x = X.data() + i * kNumFeat;
+    EXPECT_EQ(compact.Predict(x), Vote(trees, x));
+  }
+  // Identical trees are shared
+  std::vector<DTree*> half_trees(trees.begin(), trees.begin() + kNumFeat);
+  CompactForest half_compact;
+  half_compact.Build(half_trees, 3, kNumFeat);
+  EXPECT_EQ(compact.NumByte(), half_compact.NumByte());
+  size_t flat_bytes = 0;
+  for (DTree* tree : half_trees) {
+    FlatTree flat_tree;
+    flat_tree.Flatten(*tree);
+    flat_bytes += flat_tree.NumNode() * sizeof(FlatNode);
+  }
+  EXPECT_LT(compact.NumByte() * 2, flat_bytes);
+  // Save and load
+  compact.Save("/tmp/xforest_compact_test.model");
+  CompactForest load_compact;
+  load_compact.Load("/tmp/xforest_compact_test.model");
+  EXPECT_EQ(load_compact.NumTree(), kNumTree);
+  EXPECT_EQ(load_compact.NumClass(), 3);
+  EXPECT_EQ(load_compact.NumFeat(), kNumFeat);
+  for (index_t i = 0; i < kDataSize; ++i) {
+    const uint8* x = X.data() + i * kNumFeat;
+    EXPECT_EQ(load_compact.Predict(x), compact.Predict(x));
+  }
+  RemoveFile("/tmp/xforest_compact_test.model");
+  STLDeleteElementsAndClear(&trees);
+}
+
+TEST(CompactForestTest, Large_feature_id) {
+  // Feature ids of 2 bytes
+  const index_t num_feat = 300;
+  std::vector<uint8> X;
+  std::vector<real_t> Y;
+  GenData(num_feat, kDataSize, X, Y);
+  std::vector<DTree*> trees;
+  BuildTrees(X, Y, num_feat, 2, 1000, &trees);
+  CompactForest compact;
+  compact.Build(trees, 3, num_feat);
+  for (index_t i = 0; i < kDataSize; ++i) {
+    const uint8* x = X.data() + i * num_feat;
+    EXPECT_EQ(compact.Predict(x), Vote(trees, x));
+  }
+  STLDeleteElementsAndClear(&trees);
+}
+
+// Load a copy of file with the bytes from offset replaced
+void LoadCorrupted(const std::string& file, 
+                   size_t offset, 
+                   const std::string& bytes,
+                   size_t trim = 0) {
+  std::ifstream in(file, std::ios::binary);
+  std::string data((std::istreambuf_iterator<char>(in)),
+                   std::istreambuf_iterator<char>());
+  data.replace(offset, bytes.size(), bytes);
+  data.resize(data.size() - trim);
+  std::string bad_file = file + ".bad";
+  std::ofstream out(bad_file, std::ios::binary);
+  out.write(data.data(), data.size());
+  out.close();
+  CompactForest compact;
+  compact.Load(bad_file);
+}
+
+TEST(CompactForestTest, Corrupted_file) {
+  std::vector<uint8> X;
+  std::vector<real_t> Y;
+  GenData(kNumFeat, kDataSize, X, Y);
+  std::vector<DTree*> trees;
+  BuildTrees(X, Y, kNumFeat, 2, 1000, &trees);
+  CompactForest compact;
+  compact.Build(trees, 3, kNumFeat);
+  ASSERT_GT(compact.NumByte(), 3);
+  std::string file = "/tmp/xforest_compact_corrupted_test.model";
+  compact.Save(file);
+  // magic, num_class, num_feat, n_tree, roots and n_byte
+  size_t roots = 4 + 1 + 4 + 4;
+  size_t n_byte = roots + 4 * compact.NumTree();
+  size_t begin = n_byte + 8;
+  uint64 len = compact.NumByte() - 1;
+  std::string len_bytes((const char*)&len, sizeof(uint64));
+  uint32 root = (uint32)compact.NumByte() << 1;
+  std::string root_bytes((const char*)&root, sizeof(uint32));
+  // Unchanged file is loaded
+  LoadCorrupted(file, begin, "");
+  // The first node has feature id 127, and its children are leaf nodes
+  EXPECT_DEATH(LoadCorrupted(file, begin, "\x7F"), "Feature id");
+  EXPECT_DEATH(LoadCorrupted(file, begin + 2, "\x0B"), "Leaf class");
+  EXPECT_DEATH(LoadCorrupted(file, begin + 2, "\x02"), "Bad child");
+  EXPECT_DEATH(LoadCorrupted(file, begin, "\xFF\xFF\xFF\xFF\xFF"), 
+               "Malformed");
+  EXPECT_DEATH(LoadCorrupted(file, n_byte, len_bytes, 1), "Malformed");
+  EXPECT_DEATH(LoadCorrupted(file, roots, root_bytes), "Bad root");
+  RemoveFile(file.c_str());
+  RemoveFile((file + ".bad").c_str());
+  STLDeleteElementsAndClear(&trees);
+}
+
+}  // namespace xforest
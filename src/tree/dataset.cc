@@ -0,0 +1,104 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2018 by contributors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//------------------------------------------------------------------------------
+
+/*
+This file is the implementation of Dataset class.
+*/
+
+#include "src/tree/dataset.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace xforest {
+
+Dataset::Dataset(std::vector<uint8> X,
+                 std::vector<real_t> Y,
+                 const uint8 num_class,
+                 const index_t num_feat,
+                 const uint8 max_bin,
+                 std::vector<MaxMin> max_min,
+                 std::vector<real_t> weight)
+  : X_(std::move(X)),
+    Y_(std::move(Y)),
+    max_min_(std::move(max_min)),
+    weight_(std::move(weight)),
+    num_class_(num_class),
+    num_feat_(num_feat),
+    data_size_(Y_.size()),
+    max_bin_(max_bin) {
+  CHECK_GT(num_feat_, 0);
+  CHECK_GT(data_size_, 0);
+  CHECK_EQ(X_.size(), (uint64)num_feat_ * data_size_);
+  CHECK(max_min_.empty() || max_min_.size() == num_feat_);
+  CHECK(weight_.empty() || weight_.size() == data_size_);
+}
+
+// Bin a raw dataset
+std::shared_ptr<Dataset> Dataset::FromRaw(const real_t* X,
+                                          const real_t* Y,
+                                          const index_t num_feat,
+                                          const index_t data_size,
+                                          const uint8 num_class,
+                                          const uint8 max_bin,
+                                          const std::vector<MaxMin>* max_min) {
+  CHECK_NOTNULL(X);
+  CHECK_NOTNULL(Y);
+  std::vector<MaxMin> bins;
+  if (max_min == nullptr) {
+    FindMaxMin(X, num_feat, data_size, max_bin, &bins);
+  } else {
+    bins = *max_min;
+  }
+  std::vector<uint8> X_bin((uint64)num_feat * data_size);
+  BinData(X, num_feat, data_size, max_bin, bins, X_bin.data());
+  return std::make_shared<Dataset>(std::move(X_bin),
+                                   std::vector<real_t>(Y, Y + data_size),
+                                   num_class, 
+                                   num_feat, 
+                                   max_bin, 
+                                   std::move(bins));
+}
+
+// Load dataset from file
+std::shared_ptr<Dataset> Dataset::Load(const std::string& filename) {
+  std::vector<uint8> X;
+  std::vector<real_t> Y;
+  std::vector<MaxMin> max_min;
+  index_t num_feat = 0;
+  uint8 num_class = 0;
+  uint8 max_bin = 0;
+  LoadBinnedData(filename, &X, &Y, &num_feat, &num_class, &max_bin, &max_min);
+  // Labels must be the classes of the saved dataset
+  for (real_t y : Y) {
+    CHECK_LT(y, num_class);
+  }
+  return std::make_shared<Dataset>(std::move(X),
+                                   std::move(Y),
+                                   num_class,
+                                   num_feat,
+                                   max_bin,
+                                   std::move(max_min));
+}
+
+// Save dataset to file
+void Dataset::Save(const std::string& filename) const {
+  CHECK_EQ(max_min_.size(), num_feat_);
+  SaveBinnedData(filename, X_, Y_, num_feat_, 
+                 num_class_, max_bin_, max_min_);
+}
+
+}  // namespace xforest
@@ -0,0 +1,153 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2018 by contributors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//------------------------------------------------------------------------------
+
+/*!
+*  Copyright (c) 2018 by Contributors
+* \file dataset.h
+* \brief This file defines the Dataset class.
+*/
+#ifndef XFOREST_TREE_DATASET_H_
+#define XFOREST_TREE_DATASET_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/base/common.h"
+#include "src/tree/binning.h"
+
+namespace xforest {
+
+/*!
+* \brief Dataset owns the binned matrix (row-major, num_feat bytes per
+* row), the labels, the bin boundaries and the optional sample weights.
+* A Dataset cannot be changed after it is created, and it is shared by
+* std::shared_ptr<const Dataset>: every tree and forest trained on it
+* holds such a pointer, which is a read-only view that is safe to use
+* from any thread, and the data is never copied. The data is released
+* when the last user is gone. Basic usage:
+*
+*   std::shared_ptr<const Dataset> data = 
+*     Dataset::FromRaw(X, Y, num_feat, data_size, num_class, max_bin);
+*   Forest forest;
+*   forest.Initialize(data, hyper_param);
+*   forest.Train();
+*/
+class Dataset {
+ public:
+  /*!
+  * \brief Create dataset from binned data, and the vectors are moved
+  * into the dataset.
+  * \param X binned matrix (num_feat * data_size)
+  * \param Y label of each row
+  * \param num_class number of classification
+  * \param num_feat number of feature
+  * \param max_bin maximal bin value
+  * \param max_min bin boundaries (empty if unknown)
+  * \param weight sample weights (empty if unweighted)
+  */
+  Dataset(std::vector<uint8> X,
+          std::vector<real_t> Y,
+          const uint8 num_class,
+          const index_t num_feat,
+          const uint8 max_bin,
+          std::vector<MaxMin> max_min = std::vector<MaxMin>(),
+          std::vector<real_t> weight = std::vector<real_t>());
+  ~Dataset() { }
+
+  /*!
+  * \brief Bin a raw dataset by the max-min of its features.
+  * \param X pointer of raw dataset (row-major)
+  * \param Y pointer of label
+  * \param num_feat number of feature
+  * \param data_size size of dataset
+  * \param num_class number of classification
+  * \param max_bin maximal bin value
+  * \param max_min bin boundaries of an existing model (e.g., for warm
+  * start), and nullptr means finding them from current dataset.
+  */
+  static std::shared_ptr<Dataset> FromRaw(
+    const real_t* X, 
+    const real_t* Y,
+    const index_t num_feat,
+    const index_t data_size,
+    const uint8 num_class,
+    const uint8 max_bin,
+    const std::vector<MaxMin>* max_min = nullptr);
+
+  /*!
+  * \brief Load dataset from the cache file of SaveBinnedData().
+  * The number of classification is saved in the file, so a dataset
+  * without rows of the last classes keeps its number of classification.
+  */
+  static std::shared_ptr<Dataset> Load(const std::string& filename);
+
+  /*!
+  * \brief Save dataset to a cache file (without weights).
+  */
+  void Save(const std::string& filename) const;
+
+  /*!
+  * \brief Pointer of binned matrix.
+  */
+  inline const uint8* X() const { return X_.data(); }
+
+  /*!
+  * \brief Pointer of label.
+  */
+  inline const real_t* Y() const { return Y_.data(); }
+
+  /*!
+  * \brief Pointer of sample weights, nullptr if unweighted.
+  */
+  inline const real_t* Weight() const {
+    return weight_.empty() ? nullptr : weight_.data();
+  }
+
+  /*!
+  * \brief Binned features of a row.
+  */
+  inline const uint8* Row(index_t i) const {
+    return X_.data() + (uint64)i * num_feat_;
+  }
+
+  /*!
+  * \brief Bin boundaries of each feature (empty if unknown).
+  */
+  inline const std::vector<MaxMin>& GetMaxMin() const { return max_min_; }
+
+  inline uint8 NumClass() const { return num_class_; }
+  inline index_t NumFeat() const { return num_feat_; }
+  inline index_t DataSize() const { return data_size_; }
+  inline uint8 MaxBin() const { return max_bin_; }
+
+ protected:
+  std::vector<uint8> X_;
+  std::vector<real_t> Y_;
+  std::vector<MaxMin> max_min_;
+  std::vector<real_t> weight_;
+  uint8 num_class_ = 0;
+  index_t num_feat_ = 0;
+  index_t data_size_ = 0;
+  uint8 max_bin_ = 0;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(Dataset);
+};
+
+}  // namespace xforest
+
+#endif  // XFOREST_TREE_DATASET_H_
@@ -0,0 +1,111 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2018 by contributors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//------------------------------------------------------------------------------
+
+/*!
+*  Copyright (c) 2018 by Contributors
+* \file dataset_test.cc
+* \brief This file tests dataset.h file.
+*/
+#include "gtest/gtest.h"
+
+#include <vector>
+#include <random>
+
+#include "src/base/common.h"
+#include "src/base/file_util.h"
+#include "src/tree/dataset.h"
+#include "src/tree/forest.h"
+
+namespace xforest {
+
+static const index_t kNumFeat = 6;
+static const index_t kDataSize = 2000;
+
+// Generate a raw dataset with 2 classes
+void GenRawData(std::vector<real_t>& X, std::vector<real_t>& Y) {
+  std::mt19937 rng(1231);
+  std::uniform_real_distribution<real_t> dist(-1.0, 1.0);
+  X.resize(kNumFeat * kDataSize);
+  Y.resize(kDataSize);
+  for (index_t i = 0; i < kDataSize; ++i) {
+    real_t* row = X.data() + i * kNumFeat;
+    for (index_t j = 0; j < kNumFeat; ++j) {
+      row[j] = dist(rng);
+    }
+    Y[i] = row[0] + row[1] > 0 ? 1 : 0;
+  }
+}
+
+TEST(DatasetTest, From_raw) {
+  std::vector<real_t> X;
+  std::vector<real_t> Y;
+  GenRawData(X, Y);
+  std::shared_ptr<const Dataset> data = 
+    Dataset::FromRaw(X.data(), Y.data(), kNumFeat, kDataSize, 2, 63);
+  EXPECT_EQ(data->NumFeat(), kNumFeat);
+  EXPECT_EQ(data->DataSize(), kDataSize);
+  EXPECT_EQ(data->NumClass(), 2);
+  EXPECT_EQ(data->GetMaxMin().size(), kNumFeat);
+  EXPECT_TRUE(data->Weight() == nullptr);
+  for (index_t i = 0; i < kDataSize; ++i) {
+    EXPECT_EQ(data->Y()[i], Y[i]);
+    for (index_t j = 0; j < kNumFeat; ++j) {
+      EXPECT_LE(data->Row(i)[j], 63);
+    }
+  }
+  data->Save("/tmp/xforest_test.bin");
+  std::shared_ptr<const Dataset> new_data = 
+    Dataset::Load("/tmp/xforest_test.bin");
+  EXPECT_EQ(new_data->NumClass(), 2);
+  EXPECT_EQ(new_data->MaxBin(), 63);
+  for (index_t i = 0; i < kDataSize * kNumFeat; ++i) {
+    EXPECT_EQ(new_data->X()[i], data->X()[i]);
+  }
+  // Classes without rows
+  Dataset::FromRaw(X.data(), Y.data(), kNumFeat, kDataSize, 4, 63)
+    ->Save("/tmp/xforest_test.bin");
+  EXPECT_EQ(Dataset::Load("/tmp/xforest_test.bin")->NumClass(), 4);
+  RemoveFile("/tmp/xforest_test.bin");
+}
+
+TEST(DatasetTest, Shared_by_forest) {
+  std::vector<real_t> X;
+  std::vector<real_t> Y;
+  GenRawData(X, Y);
+  std::shared_ptr<const Dataset> data = 
+    Dataset::FromRaw(X.data(), Y.data(), kNumFeat, kDataSize, 2, 63);
+  const Dataset* ptr = data.get();
+  HyperParam param;
+  param.max_bin = 63;
+  param.n_estimators = 10;
+  param.max_features = 3;
+  param.n_jobs = 4;
+  Forest forest;
+  forest.Initialize(data, param);
+  // Forest keeps the dataset alive
+  data.reset();
+  forest.Train();
+  EXPECT_EQ(forest.GetMaxMin().size(), kNumFeat);
+  index_t correct = 0;
+  for (index_t i = 0; i < kDataSize; ++i) {
+    if (forest.Predict(ptr->Row(i)) == Y[i]) {
+      correct++;
+    }
+  }
+  EXPECT_GT(correct, kDataSize * 0.9);
+}
+
+}  // namespace xforest
@@ -20,8 +20,17 @@ This file is the implementation of DTree class.
 
 #include "src/tree/dtree.h"
 
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <mutex>
 #include <queue>
 #include <numeric>
+#include <random>
 
 namespace xforest {
 
@@ -37,22 +46,54 @@ REGISTER_DTREE("rtree", RTree);
 // DTree class
 //------------------------------------------------------------------------------
 
+// Flags of serilized node
+static const uint8 kLeafNode = 1;
+static const uint8 kHotRightNode = 2;
+
 // Build decision tree
 void DTree::BuildTree() {
+  ResetTree();
+  InitSample();
+  if (reorder_data_) {
+    InitReorderBuffer();
+  } else {
+    if (prefetch_distance_ < 0) {
+      prefetch_distance_ = PrefetchDistance(X_, num_feat_, data_size_);
+    }
+  }
   root_ = new DTNode();
   // Make root as left node
   root_->SetLeftOrRight('l');
   root_->SetLevel(1);
   root_->SetStartPos(0);
-  root_->SetEndPos(data_size_);
-  // Queue for tree growing
+  root_->SetEndPos(rowIdx_.size() - 1);
+  // Queue for breadth-first growing and
+  // stack for depth-first growing. Note that 
+  // nodes in queue are visited first.
   std::queue<DTNode*> queue;
+  std::vector<DTNode*> stack;
   queue.push(root_);
-  while (!queue.empty()) {
-    DTNode* node = queue.front();
-    if (IsLeaf(node) == false) {
-      FindPosition(node);
+  while (!queue.empty() || !stack.empty()) {
+    DTNode* node = nullptr;
+    if (!queue.empty()) {
+      node = queue.front();
+      queue.pop();
+    } else {
+      node = stack.back();
+      stack.pop_back();
+    }
+    DTNode* parent = node->Parent();
+    DTNode* brother = node->Brother();
+    if (IsLeaf(node)) {
+      MakeLeaf(node);
+    } else if (FindPosition(node) == false) {
+      // Current node has no child to use its histogram
+      histo_cache_.Release(node);
+      MakeLeaf(node);
+    } else {
       SplitData(node);
+      node->SetHotRight(node->EndPos() - node->MidPos() > 
+                        node->MidPos() + 1 - node->StartPos());
       // New left child
       DTNode* l_node = new DTNode();
       l_node->SetLeftOrRight('l');
@@ -68,32 +109,214 @@ void DTree::BuildTree() {
       // Right node can use parent and
       // brother to calculate histogram bin value
       r_node->SetParent(node);
-      r_node->SetBrother(node);
+      r_node->SetBrother(l_node);
       // Push new node
       node->SetLeftChild(l_node);
       node->SetRightChild(r_node);
-      queue.push(l_node);
-      queue.push(r_node);
+      if (l_node->Level() < bfs_depth_) {
+        queue.push(l_node);
+        queue.push(r_node);
+      } else {
+        // Left sub-tree will be finished first
+        stack.push_back(r_node);
+        stack.push_back(l_node);
+      }
       if (r_node->Level() > tree_depth_) {
         tree_depth_ = r_node->Level();
       }
       leaf_size_++;
     }
-    queue.pop();
+    // Both of the children have been visited,
+    // and we do not need the parent info anymore
+    if (parent != nullptr) {
+      histo_cache_.Release(parent);
+      histo_cache_.Release(brother);
+      parent->Clear();
+    }
+  }
+  histo_cache_.Clear();
+  // Release the reorder buffer
+  for (int i = 0; i < 2; ++i) {
+    std::vector<uint8>().swap(row_buf_[i]);
+    std::vector<real_t>().swap(label_buf_[i]);
+  }
+  std::vector<index_t>().swap(idx_buf_);
+}
+
+// Use all of the data and features by default
+void DTree::InitSample() {
+  if (rowIdx_.empty()) {
+    rowIdx_.resize(data_size_);
+    std::iota(rowIdx_.begin(), rowIdx_.end(), 0);
+  }
+  if (colIdx_.empty()) {
+    colIdx_.resize(num_feat_);
+    std::iota(colIdx_.begin(), colIdx_.end(), 0);
+  }
+}
+
+// Choose the fastest software prefetching distance
+int DTree::CalibratePrefetchDistance(const uint8* X,
+                                     const index_t num_feat,
+                                     const index_t data_size) {
+  static const int kDistance[] = { 0, 2, 4, 8, 16, 32, 64 };
+  static const uint64 kMaxBytes = 32 << 20;
+  static const int kRepeat = 3;
+  // Visit a random sample of rows, which is the 
+  // access pattern of the nodes deep in the tree
+  index_t len = std::min((uint64)data_size, 
+                         std::max((uint64)1024, kMaxBytes / num_feat));
+  std::vector<index_t> idx(len);
+  std::mt19937 rng(1231);
+  for (index_t i = 0; i < len; ++i) {
+    idx[i] = rng() % data_size;
+  }
+  int best_dist = 0;
+  double best_time = 0;
+  uint64 sum = 0;
+  for (int dist : kDistance) {
+    if (dist >= len) {
+      break;
+    }
+    double time = 0;
+    for (int r = 0; r < kRepeat; ++r) {
+      auto begin = std::chrono::high_resolution_clock::now();
+      for (index_t i = 0; i < len; ++i) {
+        if (dist > 0 && i + dist < len) {
+          const uint8* ptr = X + (uint64)idx[i + dist] * num_feat;
+          for (index_t k = 0; k < num_feat; k += 64) {
+            __builtin_prefetch(ptr + k);
+          }
+        }
+        const uint8* ptr = X + (uint64)idx[i] * num_feat;
+        for (index_t k = 0; k < num_feat; k += 16) {
+          sum += ptr[k];
+        }
+      }
+      std::chrono::duration<double> d =
+        std::chrono::high_resolution_clock::now() - begin;
+      time += d.count();
+    }
+    if (dist == 0 || time < best_time) {
+      best_time = time;
+      best_dist = dist;
+    }
+  }
+  // Keep the kernel from being optimized out
+  if (sum == kUInt64Max) {
+    LOG(INFO) << "Checksum: " << sum;
+  }
+  return best_dist;
+}
+
+// Size of the last level cache
+static uint64 LastLevelCacheBytes() {
+  long bytes = -1;
+#ifdef _SC_LEVEL3_CACHE_SIZE
+  bytes = sysconf(_SC_LEVEL3_CACHE_SIZE);
+  if (bytes <= 0) {
+    bytes = sysconf(_SC_LEVEL2_CACHE_SIZE);
   }
+#endif
+  // A typical server LLC if unknown
+  return bytes > 0 ? (uint64)bytes : 32ull << 20;
+}
+
+// Doublings of the dataset over the LLC
+int DTree::WorkingSetBucket(const index_t num_feat,
+                            const index_t data_size) {
+  static const uint64 llc_bytes = LastLevelCacheBytes();
+  uint64 bytes = (uint64)num_feat * data_size;
+  int bucket = 0;
+  for (uint64 limit = llc_bytes; bytes > limit; limit <<= 1) {
+    bucket++;
+  }
+  return bucket;
+}
+
+// Calibrate once per process for each row width and working set
+int DTree::PrefetchDistance(const uint8* X,
+                            const index_t num_feat,
+                            const index_t data_size) {
+  static std::mutex mutex;
+  static std::map<std::pair<index_t, int>, int> distance;
+  std::pair<index_t, int> key(num_feat, 
+                              WorkingSetBucket(num_feat, data_size));
+  std::lock_guard<std::mutex> lock(mutex);
+  auto iter = distance.find(key);
+  if (iter == distance.end()) {
+    int dist = CalibratePrefetchDistance(X, num_feat, data_size);
+    iter = distance.emplace(key, dist).first;
+  }
+  return iter->second;
 }
 
 // If current node is a leaf node?
 bool DTree::IsLeaf(DTNode* node) {
-  if (node->Level() == max_depth_ ||
-      node->DataSize() < min_samples_split_) {
-    node->SetLeaf();
-    node->SetLeafVal(LeafVal(node));
-    // Clear tmp info
-    node->Clear();
-    return true;
+  return IsLeaf(node, node->DataSize());
+}
+
+// If current node is a leaf node?
+bool DTree::IsLeaf(DTNode* node, index_t len) {
+  return node->Level() >= max_depth_ ||
+         len < min_samples_split_ ||
+         leaf_size_ >= max_leaf_;
+}
+
+// Check impurity decrease of the best split
+bool DTree::AcceptSplit(DTNode* node, index_t len, real_t impurity) {
+  real_t decrease = (real_t)len / rowIdx_.size() * 
+                    (impurity - node->LowestImpurity());
+  if (decrease < min_impurity_dec_) {
+    return false;
   }
-  return false;
+  importance_[node->BestFeatID()] += decrease;
+  return true;
+}
+
+// Make current node a leaf node
+void DTree::MakeLeaf(DTNode* node) {
+  node->SetLeaf();
+  node->SetLeafVal(LeafVal(node));
+  // Clear tmp info
+  node->Clear();
+}
+
+// Copy the sampled rows into the reorder buffer
+void DTree::InitReorderBuffer() {
+  index_t len = rowIdx_.size();
+  for (int i = 0; i < 2; ++i) {
+    row_buf_[i].resize((uint64)len * num_feat_);
+    label_buf_[i].resize(len);
+  }
+  idx_buf_.resize(len);
+  uint8* ptr = row_buf_[0].data();
+  for (index_t i = 0; i < len; ++i) {
+    index_t row_idx = rowIdx_[i];
+    memcpy(ptr, X_ + (uint64)row_idx * num_feat_, num_feat_);
+    label_buf_[0][i] = Y_[row_idx];
+    ptr += num_feat_;
+  }
+}
+
+// Delete a sub-tree
+void DTree::DeleteNode(DTNode* node) {
+  if (node == nullptr) {
+    return;
+  }
+  DeleteNode(node->LeftChild());
+  DeleteNode(node->RightChild());
+  delete node;
+}
+
+// Start over from an empty tree
+void DTree::ResetTree() {
+  ClearNodeStat();
+  DeleteNode(root_);
+  root_ = nullptr;
+  leaf_size_ = 1;
+  tree_depth_ = 1;
+  std::fill(importance_.begin(), importance_.end(), 0);
 }
 
 // Get a leaf node by given the data x
@@ -118,12 +341,76 @@ real_t DTree::Predict(const uint8* x) {
 
 // Serilize tree to string
 void DTree::Serilize(std::string* str) {
-  return;
+  CHECK_NOTNULL(str);
+  CHECK_NOTNULL(root_);
+  str->clear();
+  str->append((const char*)&leaf_size_, sizeof(index_t));
+  str->append((const char*)&tree_depth_, sizeof(uint8));
+  SerilizeNode(root_, str);
+  index_t num_feat = importance_.size();
+  str->append((const char*)&num_feat, sizeof(index_t));
+  str->append((const char*)importance_.data(), sizeof(real_t) * num_feat);
 }
 
 // Deserilize tree from string
 void DTree::Deserilize(const std::string& str) {
-  return;
+  ClearNodeStat();
+  DeleteNode(root_);
+  size_t pos = 0;
+  CHECK_GE(str.size(), sizeof(index_t) + sizeof(uint8));
+  memcpy(&leaf_size_, str.data(), sizeof(index_t));
+  pos += sizeof(index_t);
+  memcpy(&tree_depth_, str.data() + pos, sizeof(uint8));
+  pos += sizeof(uint8);
+  root_ = DeserilizeNode(str, &pos);
+  index_t num_feat = 0;
+  CHECK_LE(pos + sizeof(index_t), str.size());
+  memcpy(&num_feat, str.data() + pos, sizeof(index_t));
+  pos += sizeof(index_t);
+  CHECK_EQ(pos + sizeof(real_t) * num_feat, str.size());
+  importance_.resize(num_feat);
+  memcpy(importance_.data(), str.data() + pos, sizeof(real_t) * num_feat);
+}
+
+// Serilize a sub-tree in pre-order
+void DTree::SerilizeNode(const DTNode* node, std::string* str) {
+  uint8 flag = node->IsLeaf() ? kLeafNode : 0;
+  if (node->HotRight()) {
+    flag |= kHotRightNode;
+  }
+  str->append((const char*)&flag, sizeof(uint8));
+  if (node->IsLeaf()) {
+    str->append((const char*)&node->leaf_val, sizeof(real_t));
+    return;
+  }
+  str->append((const char*)&node->best_feat_id, sizeof(index_t));
+  str->append((const char*)&node->best_bin_val, sizeof(uint8));
+  SerilizeNode(node->LeftChild(), str);
+  SerilizeNode(node->RightChild(), str);
+}
+
+// Deserilize a sub-tree in pre-order
+DTNode* DTree::DeserilizeNode(const std::string& str, size_t* pos) {
+  CHECK_LT(*pos, str.size());
+  DTNode* node = new DTNode();
+  // Temp info is only used by training
+  node->Clear();
+  uint8 flag = str[(*pos)++];
+  node->SetHotRight(flag & kHotRightNode);
+  if (flag & kLeafNode) {
+    CHECK_LE(*pos + sizeof(real_t), str.size());
+    memcpy(&node->leaf_val, str.data() + *pos, sizeof(real_t));
+    *pos += sizeof(real_t);
+    node->SetLeaf();
+    return node;
+  }
+  CHECK_LE(*pos + sizeof(index_t) + sizeof(uint8), str.size());
+  memcpy(&node->best_feat_id, str.data() + *pos, sizeof(index_t));
+  *pos += sizeof(index_t);
+  node->SetBestBinVal(str[(*pos)++]);
+  node->SetLeftChild(DeserilizeNode(str, pos));
+  node->SetRightChild(DeserilizeNode(str, pos));
+  return node;
 }
 
 // Print decision to human-readable txt format
@@ -133,21 +420,77 @@ void DTree::PrintToTXT(std::string* str) {
 
 // Split current node
 void DTree::SplitData(DTNode* node) {
-  index_t ptr_head = node->StartPos();
-  index_t ptr_tail = node->EndPos();
+  index_t start_pos = node->StartPos();
+  index_t end_pos = node->EndPos();
   index_t best_feat_id = node->BestFeatID();
   uint8 best_bin_val = node->BestBinVal();
-  uint8* ptr = X_ + best_feat_id;
+  if (reorder_data_) {
+    // Partition rows into the other buffer: left rows
+    // grow from the head and right rows from the tail
+    int buf = BufID(node);
+    const uint8* src = row_buf_[buf].data();
+    const real_t* src_y = label_buf_[buf].data();
+    uint8* dst = row_buf_[buf ^ 1].data();
+    real_t* dst_y = label_buf_[buf ^ 1].data();
+    // Number of left and right rows before each chunk, so
+    // that chunks can be partitioned independently and the 
+    // result is the same as a single pass
+    index_t n_chunk = NumChunk(node->DataSize());
+    std::vector<index_t> n_left(n_chunk + 1, 0);
+    std::vector<index_t> n_right(n_chunk + 1, 0);
+    if (n_chunk > 1) {
+      ParallelFor(start_pos, end_pos, n_chunk,
+        [&](index_t c, index_t begin, index_t end) {
+          const uint8* ptr = src + (uint64)begin * num_feat_ + best_feat_id;
+          index_t n = 0;
+          for (index_t i = begin; i <= end; ++i) {
+            n += *ptr <= best_bin_val;
+            ptr += num_feat_;
+          }
+          n_left[c+1] = n;
+          n_right[c+1] = end - begin + 1 - n;
+        });
+      std::partial_sum(n_left.begin(), n_left.end(), n_left.begin());
+      std::partial_sum(n_right.begin(), n_right.end(), n_right.begin());
+    }
+    index_t mid_pos = 0;
+    ParallelFor(start_pos, end_pos, n_chunk,
+      [&](index_t c, index_t begin, index_t end) {
+        index_t ptr_head = start_pos + n_left[c];
+        index_t ptr_tail = end_pos + 1 - n_right[c];
+        for (index_t i = begin; i <= end; ++i) {
+          const uint8* row = src + (uint64)i * num_feat_;
+          index_t pos = row[best_feat_id] <= best_bin_val ? 
+                        ptr_head++ : --ptr_tail;
+          memcpy(dst + (uint64)pos * num_feat_, row, num_feat_);
+          dst_y[pos] = src_y[i];
+          idx_buf_[pos] = rowIdx_[i];
+        }
+        if (c == n_chunk - 1) {
+          mid_pos = ptr_head - 1;
+        }
+      });
+    memcpy(rowIdx_.data() + start_pos, 
+           idx_buf_.data() + start_pos, 
+           sizeof(index_t) * node->DataSize());
+    node->SetMidPos(mid_pos);
+    return;
+  }
+  // In-place partition by swapping, which is not split into chunks
+  index_t ptr_head = start_pos;
+  index_t ptr_tail = end_pos + 1;
+  const uint8* ptr = X_ + best_feat_id;
+  index_t dist = prefetch_distance_ > 0 ? prefetch_distance_ : 0;
   while (ptr_head < ptr_tail) {
-    uint8 bin = *(ptr + rowIdx_[ptr_head] * num_feat_);
+    if (dist > 0 && ptr_head + dist < ptr_tail) {
+      __builtin_prefetch(ptr + (uint64)rowIdx_[ptr_head + dist] * num_feat_);
+    }
+    uint8 bin = *(ptr + (uint64)rowIdx_[ptr_head] * num_feat_);
     if (bin <= best_bin_val) {
       ptr_head++;
     } else {
       // swap head and tail
-      rowIdx_[ptr_head] ^= rowIdx_[ptr_tail];
-      rowIdx_[ptr_tail] ^= rowIdx_[ptr_head];
-      rowIdx_[ptr_head] ^= rowIdx_[ptr_tail];
-      ptr_tail--;
+      std::swap(rowIdx_[ptr_head], rowIdx_[--ptr_tail]);
     }
   }
   node->SetMidPos(ptr_head-1);
@@ -161,15 +504,13 @@ void DTree::SplitData(DTNode* node) {
 real_t BTree::LeafVal(const DTNode* node) {
   index_t count_0 = 0;
   index_t count_1 = 0;
-  index_t start_pos = node->StartPos();
-  index_t end_pos = node->EndPos();
-  index_t len = node->DataSize();
-  for (index_t i = start_pos; i <= end_pos; ++i) {
-    if (Y_[rowIdx_[i]] == 0) {
+  ForEachRow(node, [&](const uint8* row, real_t y) {
+    if (y == 0) {
       count_0++;
+    } else {
+      count_1++;
     }
-    count_1 = len - count_0;
-  }
+  });
   return count_0 > count_1 ? 0.0 : 1.0;
 }
 
@@ -192,24 +533,20 @@ real_t BTree::Gini(const real_t left_0,
 }
 
 // Find best split position for current node
-void BTree::FindPosition(DTNode* node) {
-  BHistogram* histo = (BHistogram*)node->Histo();
-  histo = new BHistogram(num_feat_, max_bin_);
+bool BTree::FindPosition(DTNode* node) {
+  BHistogram* histo = new BHistogram(colIdx_.size(), max_bin_ + 1);
   // Collect histogram
   index_t total_0 = 0;
   index_t total_1 = 0;
   index_t len = node->DataSize();
-  index_t start_pos = node->StartPos();
-  index_t end_pos = node->EndPos();
   index_t col_size = colIdx_.size();
-  // If node is left node or
-  // node is right but brother is leaf
-  if (node->LeftOrRight() == 'l' || 
-      node->Brother()->IsLeaf()) {
-    for (index_t i = start_pos; i <= end_pos; ++i) {
-      index_t row_idx = rowIdx_[i];
-      uint8* ptr = X_ + row_idx * num_feat_;
-      if (Y_[row_idx] == 0) {
+  HistoBase* histo_parent = nullptr;
+  HistoBase* histo_brother = nullptr;
+  // If node is left node or we cannot
+  // get histogram of parent and brother
+  if (!GetSubtractHisto(node, &histo_parent, &histo_brother)) {
+    ForEachRow(node, [&](const uint8* ptr, real_t y) {
+      if (y == 0) {
         total_0++;
         for (index_t j = 0; j < col_size; ++j) {
           uint8 bin = *(ptr + colIdx_[j]);
@@ -221,45 +558,56 @@ void BTree::FindPosition(DTNode* node) {
           histo->count[j][bin].count_1++;
         }
       }
-    }
+    });
     total_1 = len - total_0;
   } else {  // histo = parent_histo - brother_histo
-    BHistogram* parent = (BHistogram*)node->Parent()->Histo();
-    BHistogram* brother = (BHistogram*)node->Brother()->Histo();
+    BHistogram* parent = (BHistogram*)histo_parent;
+    BHistogram* brother = (BHistogram*)histo_brother;
     total_0 = parent->total_0 - brother->total_0;
     total_1 = parent->total_1 - brother->total_1;
     for (index_t i = 0; i < col_size; ++i) {
       for (index_t j = 0; j <= max_bin_; ++j) {
         histo->count[i][j].count_0 = 
           parent->count[i][j].count_0 - brother->count[i][j].count_0;
-       	histo->count[i][j].count_1 = 
+        histo->count[i][j].count_1 = 
           parent->count[i][j].count_1 - brother->count[i][j].count_1;
       }
     }
   }
   histo->total_0 = total_0;
   histo->total_1 = total_1;
+  CacheHisto(node, histo);
+  // Pure node
+  real_t impurity = 1.0 - 
+    ((real_t)total_0*total_0 + (real_t)total_1*total_1) / ((real_t)len*len);
+  if (impurity <= min_impurity_) {
+    return false;
+  }
   // Find best split position
+  bool found = false;
   for (index_t i = 0; i < col_size; ++i) {
     Count* count = histo->count[i];
     index_t left_0 = 0;
     index_t left_1 = 0;
-    for (index_t j = 0; j <= max_bin_; ++j) {
+    for (index_t j = 0; j < max_bin_; ++j) {
       left_0 += count[j].count_0;
       left_1 += count[j].count_1;
       index_t right_0 = total_0 - left_0;
       index_t right_1 = total_1 - left_1;
+      if (left_0 + left_1 < min_samples_leaf_ ||
+          right_0 + right_1 < min_samples_leaf_) {
+        continue;
+      }
       real_t gini = Gini(left_0, left_1, right_0, right_1);
-      if (gini < node->BestGini()) {
-        node->SetBestGini(gini);
-        node->SetBestFeatID(colIdx_[j]);
-        node->SetBestBinVal(i);
+      if (gini < node->LowestImpurity()) {
+        node->SetLowestImpurity(gini);
+        node->SetBestFeatID(colIdx_[i]);
+        node->SetBestBinVal(j);
+        found = true;
       }
     }
   }
-  if (node->LeftOrRight() == 'r') {
-    node->ClearParent();
-  }
+  return found && AcceptSplit(node, len, impurity);
 }
 
 //------------------------------------------------------------------------------
@@ -270,94 +618,369 @@ void BTree::FindPosition(DTNode* node) {
 real_t MCTree::LeafVal(const DTNode* node) {
   std::vector<index_t> count(num_class_, 0);
   std::vector<index_t>::iterator result;
-  index_t start_pos = node->StartPos();
-  index_t end_pos = node->EndPos();
-  for (index_t i = start_pos; i <= end_pos; ++i) {
-    count[Y_[rowIdx_[i]]]++;
-  }
+  ForEachRow(node, [&](const uint8* row, real_t y) {
+    count[(index_t)y]++;
+  });
   result = std::max_element(count.begin(), count.end());
   return (real_t)std::distance(count.begin(), result);
 }
 
 // Find best split position for current node
-void MCTree::FindPosition(DTNode* node) {
-  MCHistogram* histo = (MCHistogram*)node->Histo();
-  histo = new MCHistogram(num_feat_, max_bin_, num_class_);
-  index_t len = node->DataSize();
-  index_t start_pos = node->StartPos();
-  index_t end_pos = node->EndPos();
-  index_t* count = histo->count;
+bool MCTree::FindPosition(DTNode* node) {
   index_t col_size = colIdx_.size();
-  index_t cc = num_class_ * col_size;
+  MCHistogram* histo = new MCHistogram(col_size, max_bin_ + 1, num_class_);
+  index_t* count = histo->count;
+  HistoBase* histo_parent = nullptr;
+  HistoBase* histo_brother = nullptr;
   // Collect histogram
-  if (node->LeftOrRight() == 'l' ||
-      node->Brother()->IsLeaf()) {
-    for (index_t i = start_pos; i <= end_pos; ++i) {
-      index_t row_idx = rowIdx_[i];
-      int y = Y_[row_idx];
-      uint8* ptr = X_ + row_idx * num_feat_;
-      for (index_t j = 0; j < col_size; ++j) {
-        count[num_class_*(*(ptr+colIdx_[j])*col_size+j)+y]++;
-      }
+  index_t count_len = histo->count_len;
+  if (!GetSubtractHisto(node, &histo_parent, &histo_brother)) {
+    // Each chunk of rows has its own histogram, and
+    // they are merged into the first one at last
+    index_t n_chunk = NumChunk(node->DataSize());
+    std::vector<std::vector<index_t>> chunk_count(n_chunk - 1);
+    ParallelFor(node->StartPos(), node->EndPos(), n_chunk,
+      [&](index_t c, index_t begin, index_t end) {
+        index_t* cnt = count;
+        if (c > 0) {
+          chunk_count[c-1].assign(count_len, 0);
+          cnt = chunk_count[c-1].data();
+        }
+        ForEachRow(node, begin, end, [&](const uint8* ptr, real_t label) {
+          index_t y = (index_t)label;
+          for (index_t j = 0; j < col_size; ++j) {
+            cnt[num_class_*(*(ptr+colIdx_[j])*col_size+j)+y]++;
+          }
+        });
+      });
+    if (n_chunk > 1) {
+      ParallelFor(0, count_len - 1, n_chunk,
+        [&](index_t c, index_t begin, index_t end) {
+          for (auto& cnt : chunk_count) {
+            for (index_t i = begin; i <= end; ++i) {
+              count[i] += cnt[i];
+            }
+          }
+        });
     }
   } else {
-    MCHistogram* histo_parent = (MCHistogram*)node->Parent()->Histo();
-    index_t* count_parent = histo_parent->count;
-    MCHistogram* histo_brother = (MCHistogram*)node->Brother()->Histo();
-    index_t* count_brother = histo_brother->count;
-    index_t count_len = histo->count_len;
+    index_t* count_parent = ((MCHistogram*)histo_parent)->count;
+    index_t* count_brother = ((MCHistogram*)histo_brother)->count;
     for (index_t i = 0; i < count_len; ++i) {
       count[i] = count_parent[i] - count_brother[i];
     }
   }
-  // Sum total count
-  std::vector<index_t> total_count(num_class_, 0);
+  CacheHisto(node, histo);
+  return FindSplit(node, histo, node->DataSize());
+}
+
+// Sum total count of each class
+void MCTree::TotalCount(const MCHistogram* histo,
+                        std::vector<index_t>* total_count) {
+  index_t cc = num_class_ * colIdx_.size();
+  total_count->assign(num_class_, 0);
   for (index_t i = 0; i <= max_bin_; ++i) {
-    index_t* ptr = count + i*cc;
+    const index_t* ptr = histo->count + i*cc;
     for (uint8 c = 0; c < num_class_; ++c) {
-      total_count[c] += *ptr;
+      (*total_count)[c] += *ptr;
       ptr++;
     }
   }
+}
+
+// Find best split position from histogram
+bool MCTree::FindSplit(DTNode* node, 
+                       const MCHistogram* histo, 
+                       const index_t len) {
+  std::vector<index_t> total_count;
+  TotalCount(histo, &total_count);
+  // Pure node
+  real_t impurity = Impurity(total_count, len);
+  if (impurity <= min_impurity_) {
+    return false;
+  }
   // Find best split position
+  bool found = false;
+  index_t col_size = colIdx_.size();
   for (index_t j = 0; j < col_size; ++j) {
-    std::vector<index_t> left_count(num_class_, 0);
-    std::vector<index_t> right_count(total_count);
-    index_t* base_ptr = count + j*num_class_;
-    for (index_t i = 0; i <= max_bin_; ++i) {
-      index_t* ptr = base_ptr + cc*i;
-      for (uint8 c = 0; c < num_class_; ++c) {
-        left_count[c] += *ptr;
-        right_count[c] -= *ptr;
-        ptr++;
-      }
-      index_t left_sum = 
-        std::accumulate(left_count.begin(), left_count.end(), 0);
-      index_t right_sum = 
-        std::accumulate(right_count.begin(), right_count.end(), 0);
-      real_t real_left_sum = 0.0;
-      real_t real_right_sum = 0.0;
-      for (uint8 c = 0; c < num_class_; ++c) {
-        real_t tmp = (real_t)left_count[c] / left_sum;
-        real_left_sum += tmp*tmp;
-        tmp = (real_t)right_count[c] / right_sum;
-        real_right_sum += tmp*tmp;
-      }
-      real_t left_gini = 1.0 - real_left_sum;
-      left_gini *= (real_t)left_sum / len;
-      real_t right_gini = 1.0 - real_right_sum;
-      right_gini *= (real_t)right_sum / len;
-      real_t gini = left_gini + right_gini;
-      if (gini < node->BestGini()) {
-        node->SetBestGini(gini);
-        node->SetBestFeatID(colIdx_[j]);
-        node->SetBestBinVal(i);
+    uint8 bin = 0;
+    real_t gini = FindFeatureSplit(histo, j, total_count, len, &bin);
+    if (gini < node->LowestImpurity()) {
+      node->SetLowestImpurity(gini);
+      node->SetBestFeatID(colIdx_[j]);
+      node->SetBestBinVal(bin);
+      found = true;
+    }
+  }
+  return found && AcceptSplit(node, len, impurity);
+}
+
+// Gini impurity of class counts
+real_t MCTree::Impurity(const std::vector<index_t>& total_count,
+                        const index_t len) {
+  real_t impurity = 1.0;
+  for (uint8 c = 0; c < num_class_; ++c) {
+    real_t tmp = (real_t)total_count[c] / len;
+    impurity -= tmp*tmp;
+  }
+  return impurity;
+}
+
+// Find best split of the j-th sampled feature
+real_t MCTree::FindFeatureSplit(const MCHistogram* histo,
+                                const index_t j,
+                                const std::vector<index_t>& total_count,
+                                const index_t len,
+                                uint8* best_bin) {
+  index_t cc = num_class_ * colIdx_.size();
+  std::vector<index_t> left_count(num_class_, 0);
+  std::vector<index_t> right_count(total_count.begin(), total_count.end());
+  const index_t* base_ptr = histo->count + j*num_class_;
+  index_t left_sum = 0;
+  real_t best_gini = kFloatMax;
+  for (index_t i = 0; i < max_bin_; ++i) {
+    const index_t* ptr = base_ptr + cc*i;
+    for (uint8 c = 0; c < num_class_; ++c) {
+      left_count[c] += *ptr;
+      right_count[c] -= *ptr;
+      left_sum += *ptr;
+      ptr++;
+    }
+    index_t right_sum = len - left_sum;
+    if (left_sum < min_samples_leaf_ || 
+        right_sum < min_samples_leaf_) {
+      continue;
+    }
+    real_t real_left_sum = 0.0;
+    real_t real_right_sum = 0.0;
+    for (uint8 c = 0; c < num_class_; ++c) {
+      real_t tmp = (real_t)left_count[c] / left_sum;
+      real_left_sum += tmp*tmp;
+      tmp = (real_t)right_count[c] / right_sum;
+      real_right_sum += tmp*tmp;
+    }
+    real_t left_gini = 1.0 - real_left_sum;
+    left_gini *= (real_t)left_sum / len;
+    real_t right_gini = 1.0 - real_right_sum;
+    right_gini *= (real_t)right_sum / len;
+    real_t gini = left_gini + right_gini;
+    if (gini < best_gini) {
+      best_gini = gini;
+      *best_bin = i;
+    }
+  }
+  return best_gini;
+}
+
+// Delete the statistics of online update
+MCTree::~MCTree() {
+  ClearNodeStat();
+}
+
+// Delete the statistics of online update, keyed by the old nodes
+void MCTree::ClearNodeStat() {
+  for (auto& kv : leaf_stat_) {
+    delete kv.second.histo;
+  }
+  leaf_stat_.clear();
+  online_bytes_ = 0;
+}
+
+// Update tree by a mini-batch of new rows
+void MCTree::Update(const Dataset& batch,
+                    const std::vector<index_t>& row_idx,
+                    const HyperParam& hyper_param) {
+  CHECK_NOTNULL(root_);
+  CHECK_GE(hyper_param.grace_period, 1);
+  CHECK_GT(hyper_param.split_confidence, 0);
+  CHECK_LT(hyper_param.split_confidence, 1);
+  CHECK_GT(hyper_param.label_confidence, 0);
+  CHECK_LT(hyper_param.label_confidence, 1);
+  if (num_class_ == 0) {
+    // Deserilized tree
+    num_class_ = batch.NumClass();
+    num_feat_ = batch.NumFeat();
+  }
+  CHECK_EQ(batch.NumClass(), num_class_);
+  CHECK_EQ(batch.NumFeat(), num_feat_);
+  SetParam(hyper_param);
+  split_confidence_ = hyper_param.split_confidence;
+  label_confidence_ = hyper_param.label_confidence;
+  tie_threshold_ = hyper_param.tie_threshold;
+  if (colIdx_.empty()) {
+    colIdx_.resize(num_feat_);
+    std::iota(colIdx_.begin(), colIdx_.end(), 0);
+  }
+  if (importance_.empty()) {
+    importance_.assign(num_feat_, 0);
+  }
+  index_t col_size = colIdx_.size();
+  // Route each row to its leaf node and update the histogram
+  for (index_t row_idx_i : row_idx) {
+    const uint8* x = batch.Row(row_idx_i);
+    index_t y = (index_t)batch.Y()[row_idx_i];
+    CHECK_LT(y, num_class_);
+    DTNode* node = root_;
+    uint8 level = 1;
+    while (!node->IsLeaf()) {
+      node = x[node->BestFeatID()] <= node->BestBinVal() ?
+             node->LeftChild() : node->RightChild();
+      level++;
+    }
+    LeafStat& stat = leaf_stat_[node];
+    if (stat.histo == nullptr) {
+      uint64 bytes = sizeof(index_t) * col_size * (max_bin_ + 1) * num_class_;
+      EvictLeafStat(node, bytes, hyper_param.max_online_histogram_bytes);
+      stat.histo = new MCHistogram(col_size, max_bin_ + 1, num_class_);
+      stat.level = level;
+      online_bytes_ += bytes;
+    }
+    index_t* count = stat.histo->count;
+    for (index_t j = 0; j < col_size; ++j) {
+      count[num_class_*(x[colIdx_[j]]*col_size+j)+y]++;
+    }
+    stat.len++;
+  }
+  // Leaf nodes that observe enough new rows, while the labels of
+  // the others follow their new rows once the majority is significant
+  std::vector<DTNode*> nodes;
+  std::vector<index_t> total_count;
+  for (auto& kv : leaf_stat_) {
+    TotalCount(kv.second.histo, &total_count);
+    kv.first->SetLeafVal(OnlineLeafVal(total_count, kv.second.len, 
+                                       kv.first->leaf_val));
+    if (kv.second.len - kv.second.last_check >= 
+        (index_t)hyper_param.grace_period) {
+      nodes.push_back(kv.first);
+    }
+  }
+  // Shallow and large leaf nodes are split first
+  std::sort(nodes.begin(), nodes.end(), [&](DTNode* a, DTNode* b) {
+    const LeafStat& sa = leaf_stat_[a];
+    const LeafStat& sb = leaf_stat_[b];
+    return sa.level != sb.level ? sa.level < sb.level : sa.len > sb.len;
+  });
+  for (DTNode* node : nodes) {
+    LeafStat& stat = leaf_stat_[node];
+    stat.last_check = stat.len;
+    TryHoeffdingSplit(node, &stat);
+  }
+}
+
+// Drop the leaf nodes with the fewest new rows
+void MCTree::EvictLeafStat(const DTNode* node, uint64 bytes, int64 budget) {
+  while (budget >= 0 && online_bytes_ + bytes > (uint64)budget) {
+    auto victim = leaf_stat_.end();
+    for (auto iter = leaf_stat_.begin(); iter != leaf_stat_.end(); ++iter) {
+      if (iter->first != node && iter->second.histo != nullptr &&
+          (victim == leaf_stat_.end() || 
+           iter->second.len < victim->second.len)) {
+        victim = iter;
       }
     }
+    // At least one histogram is kept
+    if (victim == leaf_stat_.end()) {
+      return;
+    }
+    online_bytes_ -= victim->second.histo->Bytes();
+    delete victim->second.histo;
+    leaf_stat_.erase(victim);
   }
-  if (node->LeftOrRight() == 'r') {
-    node->ClearParent();
+}
+
+// Keep the label until the new rows disagree significantly
+real_t MCTree::OnlineLeafVal(const std::vector<index_t>& count, 
+                             const index_t len, 
+                             const real_t label) {
+  index_t best = std::distance(count.begin(),
+    std::max_element(count.begin(), count.end()));
+  index_t cur = (index_t)label;
+  CHECK_LT(cur, num_class_);
+  if (len == 0 || best == cur) {
+    return label;
+  }
+  // Hoeffding bound of the mean of 1[y=best] - 1[y=cur] in [-1, 1]
+  real_t epsilon = std::sqrt(2.0 * std::log(1.0 / label_confidence_) / len);
+  if ((real_t)(count[best] - count[cur]) / len > epsilon) {
+    return (real_t)best;
   }
+  return label;
+}
+
+// Split a leaf node by Hoeffding bound
+void MCTree::TryHoeffdingSplit(DTNode* node, LeafStat* stat) {
+  const MCHistogram* histo = stat->histo;
+  index_t len = stat->len;
+  std::vector<index_t> total_count;
+  TotalCount(histo, &total_count);
+  node->SetLeafVal(OnlineLeafVal(total_count, len, node->leaf_val));
+  real_t impurity = Impurity(total_count, len);
+  if (stat->level >= max_depth_ || 
+      leaf_size_ >= max_leaf_ ||
+      impurity <= min_impurity_) {
+    return;
+  }
+  // Best and second best gain of features
+  real_t best_gain = 0;
+  real_t second_gain = 0;
+  index_t best_j = 0;
+  uint8 best_bin = 0;
+  index_t col_size = colIdx_.size();
+  for (index_t j = 0; j < col_size; ++j) {
+    uint8 bin = 0;
+    real_t gain = impurity - FindFeatureSplit(histo, j, total_count, len, &bin);
+    if (gain > best_gain) {
+      second_gain = best_gain;
+      best_gain = gain;
+      best_j = j;
+      best_bin = bin;
+    } else if (gain > second_gain) {
+      second_gain = gain;
+    }
+  }
+  // Hoeffding bound, and the range of gini gain is 1
+  real_t epsilon = std::sqrt(std::log(1.0 / split_confidence_) / (2.0 * len));
+  if (best_gain <= min_impurity_dec_ ||
+      (best_gain - second_gain <= epsilon && epsilon >= tie_threshold_)) {
+    return;
+  }
+  // Children start from the label of the node
+  std::vector<index_t> left_count(num_class_, 0);
+  index_t cc = num_class_ * col_size;
+  for (index_t i = 0; i <= best_bin; ++i) {
+    const index_t* ptr = histo->count + cc*i + best_j*num_class_;
+    for (uint8 c = 0; c < num_class_; ++c) {
+      left_count[c] += ptr[c];
+    }
+  }
+  std::vector<index_t> right_count(num_class_);
+  index_t left_len = 0;
+  for (uint8 c = 0; c < num_class_; ++c) {
+    right_count[c] = total_count[c] - left_count[c];
+    left_len += left_count[c];
+  }
+  DTNode* l_node = new DTNode();
+  DTNode* r_node = new DTNode();
+  l_node->Clear();
+  r_node->Clear();
+  l_node->SetLeaf();
+  r_node->SetLeaf();
+  l_node->SetLeafVal(OnlineLeafVal(left_count, left_len, node->leaf_val));
+  r_node->SetLeafVal(OnlineLeafVal(right_count, len - left_len, 
+                                   node->leaf_val));
+  node->is_leaf = false;
+  node->SetBestFeatID(colIdx_[best_j]);
+  node->SetBestBinVal(best_bin);
+  node->SetLeftChild(l_node);
+  node->SetRightChild(r_node);
+  node->SetHotRight(len - left_len > left_len);
+  leaf_size_++;
+  if (stat->level + 1 > tree_depth_) {
+    tree_depth_ = stat->level + 1;
+  }
+  online_bytes_ -= stat->histo->Bytes();
+  delete stat->histo;
+  leaf_stat_.erase(node);
 }
 
 //------------------------------------------------------------------------------
@@ -370,8 +993,8 @@ real_t RTree::LeafVal(const DTNode* node) {
 }
 
 // Find best split position for current node
-void RTree::FindPosition(DTNode* node) {
-  
+bool RTree::FindPosition(DTNode* node) {
+  return false;
 }
 
 }  // namespace xforest
\ No newline at end of file
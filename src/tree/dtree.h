@@ -24,38 +24,25 @@
 
 #include "src/base/common.h"
 #include "src/base/class_register.h"
+#include "src/base/work_stealing_pool.h"
 #include "src/solver/hyper_parameter.h"
+#include "src/tree/dataset.h"
+#include "src/tree/histogram_cache.h"
 
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace xforest {
 
-/*!
-* \brief Find maximal and minimal value for each feature.
-* For Histogram decision tree, we need to map original feature
-* value to 8-bit bin value, hence here we need to find the
-* of the maximal and minimal value for each feature.
-*/
-struct MaxMin {
-  real_t gap = 0.0;
-  real_t max_feat = kFloatMin;
-  real_t min_feat = kFloatMax;
-};
-
 /*!
 * \brief Temp information during training. 
 * This information will not be used for inference and 
 * we can delete it on-the-fly.
 */
 struct TInfo {
-  /*!
-  * \brief Deconstructor.
-  * Note that the parent and histo field will be cleared
-  * by other functions.
-  */
-  ~TInfo() { 
-    delete histo; 
-  }
   /*! \brief Left node ('l') or right node ('r') */
   char l_or_r;
   /*! \brief depth of current node. */
@@ -72,14 +59,12 @@ struct TInfo {
   * \brief Parent node of current node, which will be used
   * for calculating histogram value of current node.
   */
-  void* parent = nullptr;
+  DTNode* parent = nullptr;
   /*!
   * \brief Brother node of current node, which will be used
   * for calculating histogram value of current node.
   */
-  void* brother = nullptr;
-  /*! \brief Histigram bin data structure. */
-  void* histo = nullptr;
+  DTNode* brother = nullptr;
 };
 
 /*!
@@ -87,6 +72,17 @@ struct TInfo {
 */
 class DTNode {
  public:
+  /*!
+  * \brief Constructor. The temp information is allocated
+  * here and will be released by Clear() on-the-fly.
+  */
+  DTNode() : info(new TInfo()) { }
+  /*!
+  * \brief Deconstructor.
+  */
+  ~DTNode() {
+    delete info;
+  }
   /*! \brief Wether current node is a leaf node? */ 
   bool is_leaf = false;
   /*! \brief Leaf node value. */ 
@@ -99,6 +95,8 @@ class DTNode {
   index_t best_feat_id = 0;
   /*! \brief Best split value of current node. */
   uint8 best_bin_val = 0;
+  /*! \brief Wether the right child is taken by more training rows. */
+  bool hot_right = false;
   /*! \brief Temp information used by training process. */
   TInfo* info = nullptr;
   /*!
@@ -106,13 +104,14 @@ class DTNode {
   */
   inline void Clear() { 
     delete info;
+    info = nullptr;
   }
   /*!
   * \brief Clear parent information after calculating
   * histogram value.
   */
   inline void ClearParent() {
-    delete info->parent->info;
+    info->parent->Clear();
   }
   /*!
   * \brief Wether current node is a leaf node?
@@ -187,6 +186,18 @@ class DTNode {
     best_bin_val = val;
   }
   /*!
+  * \brief Wether the right child is taken by more training rows.
+  */
+  inline bool HotRight() const {
+    return hot_right;
+  }
+  /*!
+  * \brief Set the child taken by more training rows.
+  */
+  inline void SetHotRight(bool val) {
+    hot_right = val;
+  }
+  /*!
   * \brief Wether current node is a left or a Right node.
   */
   inline char LeftOrRight() const {
@@ -261,40 +272,28 @@ class DTNode {
   /*!
   * \brief Get parent node of current node.
   */
-  inline void* Parent() const {
+  inline DTNode* Parent() const {
     return info->parent;
   }
   /*!
   * \brief Set parent node of current node.
   */
-  inline void SetParent(void* node) {
+  inline void SetParent(DTNode* node) {
     info->parent = node;
   }
   /*!
   * \brief Get brother node of current node.
   */
-  inline void* Brother() const {
+  inline DTNode* Brother() const {
     return info->brother;
   }
   /*!
   * \brief Set brother node of current node.
   */
-  inline void SetBrother(void* node) {
+  inline void SetBrother(DTNode* node) {
     info->brother = node;
   }
   /*!
-  * \brief Get histogram bin of current node.
-  */
-  inline void* Histo() const {
-    return info->histo;
-  }
-  /*!
-  * \brief Set histogram bin of current node. 
-  */
-  inline void SetHisto(void* histo) {
-    info->histo = histo;
-  }
-  /*!
   * \brief Get data size allocated for current node.
   */
   inline index_t DataSize() const {
@@ -317,7 +316,9 @@ class DTree {
   /*!
    * \brief DTree deconstructor 
    */
-  virtual ~DTree() { }
+  virtual ~DTree() {
+    DeleteNode(root_);
+  }
 
   /*!
    * \brief Initialize decision tree.
@@ -340,25 +341,33 @@ class DTree {
     CHECK_LE(num_class, 255);
     CHECK_GT(num_feat, 0);
     CHECK_GT(data_size, 0);
-    CHECK_GT(hyper_param.max_bin, 10);
-    CHECK_LE(hyper_param.max_bin, 255);
-    CHECK_GT(hyper_param.max_depth, 1);
-    CHECK_LE(hyper_param.max_depth, 255);
-    CHECK_GE(hyper_param.min_samples_split, 2);
-    CHECK_GE(hyper_param.min_samples_leaf, 1);
-    CHECK_GE(hyper_param.max_leaf_nodes, 2);
+    data_.reset();
     X_ = X;
     Y_ = Y;
     num_class_ = num_class;
     num_feat_ = num_feat;
     data_size_ = data_size;
-    max_bin_ = hyper_param.max_bin;
-    max_depth_ = hyper_param.max_depth;
-    min_samples_split_ = hyper_param.min_samples_split;
-    min_samples_leaf_ = hyper_param.min_samples_leaf;
-    max_leaf_ = hyper_param.max_leaf_nodes;
-    min_impurity_dec_ = hyper_param.min_impurity_decrease;
-    min_impurity_ = hyper_param.min_impurity_split;
+    SetParam(hyper_param);
+    importance_.assign(num_feat, 0);
+  }
+
+  /*!
+   * \brief Initialize decision tree on a shared dataset, which
+   * is kept alive by the tree.
+   * \param data shared dataset
+   * \param hyper_param hyper-parameter used by decision tree
+   */
+  void Initialize(std::shared_ptr<const Dataset> data,
+                  const HyperParam& hyper_param) {
+    CHECK_NOTNULL(data.get());
+    CHECK_LE(data->MaxBin(), hyper_param.max_bin);
+    Initialize(data->X(), 
+               data->Y(), 
+               data->NumClass(), 
+               data->NumFeat(), 
+               data->DataSize(), 
+               hyper_param);
+    data_ = std::move(data);
   }
 
   /*!
@@ -385,6 +394,37 @@ class DTree {
    */
   void BuildTree();
 
+  /*!
+   * \brief Choose the software prefetching distance by timing
+   * a gather kernel on randomly ordered rows with a set of 
+   * candidate distances.
+   * \param X pointer of dataset
+   * \param num_feat number of feature
+   * \param data_size size of dataset
+   * \return the fastest prefetching distance (0 means disabled)
+   */
+  static int CalibratePrefetchDistance(const uint8* X,
+                                       const index_t num_feat,
+                                       const index_t data_size);
+
+  /*!
+   * \brief CalibratePrefetchDistance() of the first dataset of each
+   * row width (num_feat) and working set (see WorkingSetBucket()) in
+   * this process, which is cached, so that the trees trained afterwards
+   * do not run the benchmark again.
+   */
+  static int PrefetchDistance(const uint8* X,
+                              const index_t num_feat,
+                              const index_t data_size);
+
+  /*!
+   * \brief Bucket of the bytes of a dataset against the last level
+   * cache: 0 if it fits in the cache, and k if it is 2^(k-1) to 2^k
+   * times larger.
+   */
+  static int WorkingSetBucket(const index_t num_feat,
+                              const index_t data_size);
+
   /*!
    * \breif Given data x, predict label y 
    * \param x pointer of data example
@@ -393,7 +433,8 @@ class DTree {
   real_t Predict(const uint8* x);
 
   /*!
-   * \breif Serilize a decision tree to binary string.
+   * \breif Serilize a decision tree to binary string. Only the
+   * nodes used by inference are serilized in pre-order.
    * \param str pointer of bianry string
    */
   void Serilize(std::string* str);
@@ -410,6 +451,50 @@ class DTree {
    */
   void PrintToTXT(std::string* str);
 
+  /*!
+   * \brief Impurity-based importance of each feature, which is the
+   * total impurity decrease (weighted by the proportion of samples 
+   * reaching the node) of the splits using the feature. It is 
+   * accumulated while the tree is built.
+   */
+  inline const std::vector<real_t>& FeatureImportances() const {
+    return importance_;
+  }
+
+  /*!
+   * \brief Root node of the tree (nullptr before training).
+   */
+  inline const DTNode* Root() const {
+    return root_;
+  }
+
+  /*!
+   * \brief Histogram cache used in training.
+   */
+  inline const HistogramCache& HistoCache() const {
+    return histo_cache_;
+  }
+
+  /*!
+   * \brief Minimal number of rows of a chunk.
+   */
+  static const index_t kMinChunkRows = 4096;
+
+  /*!
+   * \brief Split the histogram building and data partition of large 
+   * nodes into row chunks, which are run as tasks of the given pool 
+   * and can be stolen by idle workers. The pool must be alive until 
+   * BuildTree() returns, and nullptr means single-threaded.
+   * \param pool work-stealing pool
+   * \param min_chunk_rows minimal number of rows of a chunk
+   */
+  inline void SetPool(WorkStealingPool* pool,
+                      index_t min_chunk_rows = kMinChunkRows) {
+    CHECK_GT(min_chunk_rows, 0);
+    pool_ = pool;
+    min_chunk_rows_ = min_chunk_rows;
+  }
+
  protected:
   /*!
    * \breif Maximal histogram bin value, range from (0, 255].
@@ -439,6 +524,23 @@ class DTree {
    * \breif Minimal impurity required to split a node.
    */
   real_t min_impurity_;
+  /*!
+   * \brief Physically reorder the sampled rows (and labels) for
+   * each node, so that histogram kernels can scan the rows of a 
+   * node sequentially instead of gathering them by rowIdx_.
+   */
+  bool reorder_data_ = false;
+  /*!
+   * \brief Software prefetching distance (in rows) used by the 
+   * index-gathered loops, 0 means disabled and -1 means it will 
+   * be chosen by CalibratePrefetchDistance() before training.
+   */
+  int prefetch_distance_ = 0;
+  /*!
+   * \brief Nodes above this level are grown breadth-first, and 
+   * the others are grown depth-first.
+   */
+  int bfs_depth_ = 256;
   /*!
    * \breif Sampled index of dataset.
    */
@@ -471,14 +573,228 @@ class DTree {
    * \breif Size of dataset.
    */
   index_t data_size_ = 0;
+  /*!
+   * \brief Shared dataset, which owns X_ and Y_ if it is not nullptr.
+   */
+  std::shared_ptr<const Dataset> data_;
   /*!
    * \breif Pointer of dataset.
    */
-  uint8* X_ = nullptr;
+  const uint8* X_ = nullptr;
   /*!
    * \breif Pointer of label.
    */
-  real_t* Y_ = nullptr;
+  const real_t* Y_ = nullptr;
+  /*!
+   * \brief Double buffer of the reordered rows. The rows of a node 
+   * at level L are stored contiguously in row_buf_[(L-1)%2] in the 
+   * range [StartPos, EndPos], and SplitData() partitions them into 
+   * the other buffer. Only used when reorder_data_ is true.
+   */
+  std::vector<uint8> row_buf_[2];
+  /*!
+   * \brief Double buffer of the reordered labels.
+   */
+  std::vector<real_t> label_buf_[2];
+  /*!
+   * \brief Scratch space used to partition rowIdx_ in reorder mode.
+   */
+  std::vector<index_t> idx_buf_;
+  /*!
+   * \brief Total weighted impurity decrease of each feature.
+   */
+  std::vector<real_t> importance_;
+  /*!
+   * \brief Histograms kept for histogram subtraction.
+   */
+  HistogramCache histo_cache_;
+  /*!
+   * \brief Pool that runs the row chunks of large nodes.
+   */
+  WorkStealingPool* pool_ = nullptr;
+  /*!
+   * \brief Minimal number of rows of a chunk.
+   */
+  index_t min_chunk_rows_ = kMinChunkRows;
+
+  /*!
+   * \brief Set the hyper-parameters of growing a tree.
+   */
+  void SetParam(const HyperParam& hyper_param) {
+    CHECK_GT(hyper_param.max_bin, 10);
+    CHECK_LE(hyper_param.max_bin, 255);
+    CHECK_GT(hyper_param.max_depth, 1);
+    CHECK_LE(hyper_param.max_depth, 255);
+    CHECK_GE(hyper_param.min_samples_split, 2);
+    CHECK_GE(hyper_param.min_samples_leaf, 1);
+    CHECK_GE(hyper_param.max_leaf_nodes, 2);
+    max_bin_ = hyper_param.max_bin;
+    max_depth_ = hyper_param.max_depth;
+    min_samples_split_ = hyper_param.min_samples_split;
+    min_samples_leaf_ = hyper_param.min_samples_leaf;
+    max_leaf_ = hyper_param.max_leaf_nodes;
+    min_impurity_dec_ = hyper_param.min_impurity_decrease;
+    min_impurity_ = hyper_param.min_impurity_split;
+    reorder_data_ = hyper_param.reorder_data;
+    prefetch_distance_ = hyper_param.prefetch_distance;
+    if (hyper_param.max_histogram_bytes > 0) {
+      histo_cache_.SetMaxBytes(hyper_param.max_histogram_bytes);
+    }
+    if (hyper_param.grow_policy == "breadth_first") {
+      bfs_depth_ = 256;
+    } else if (hyper_param.grow_policy == "depth_first") {
+      bfs_depth_ = 1;
+    } else if (hyper_param.grow_policy == "hybrid") {
+      CHECK_GT(hyper_param.hybrid_depth, 0);
+      bfs_depth_ = hyper_param.hybrid_depth;
+    } else {
+      LOG(FATAL) << "Unknown grow_policy: " << hyper_param.grow_policy;
+    }
+  }
+
+  /*!
+   * \brief Add the histogram of current node to the cache. The
+   * histogram will be used by the right child, and by the brother 
+   * if current node is a left node.
+   * \param node tree node
+   * \param histo histogram of current node
+   */
+  inline void CacheHisto(const DTNode* node, HistoBase* histo) {
+    int refs = (node->LeftOrRight() == 'l' && node != root_) ? 2 : 1;
+    histo_cache_.Put(node, histo, refs);
+  }
+
+  /*!
+   * \brief Get the histograms of parent and brother, which are used
+   * to calculate the histogram of a right node by subtraction.
+   * \param node tree node
+   * \param parent histogram of parent
+   * \param brother histogram of brother
+   * \return false if current node is a left node, or any of the
+   * histograms is not in the cache (e.g., brother is a leaf node, 
+   * or the histogram was evicted), and then the histogram of current
+   * node should be built from data.
+   */
+  inline bool GetSubtractHisto(const DTNode* node,
+                               HistoBase** parent,
+                               HistoBase** brother) {
+    if (node->LeftOrRight() == 'l') {
+      return false;
+    }
+    *parent = histo_cache_.Get(node->Parent());
+    *brother = histo_cache_.Get(node->Brother());
+    return *parent != nullptr && *brother != nullptr;
+  }
+
+  /*!
+   * \brief Buffer id of the reordered rows of the given node.
+   */
+  inline int BufID(const DTNode* node) const {
+    return (node->Level() - 1) & 1;
+  }
+
+  /*!
+   * \brief Prefetch the binned features and the label of a row.
+   */
+  inline void PrefetchRow(index_t row_idx) const {
+    const uint8* ptr = X_ + (uint64)row_idx * num_feat_;
+    for (index_t k = 0; k < num_feat_; k += 64) {
+      __builtin_prefetch(ptr + k);
+    }
+    __builtin_prefetch(Y_ + row_idx);
+  }
+
+  /*!
+   * \brief Call func(row, y) on each row allocated to the given node,
+   * where row points to the binned features and y is the label. Rows 
+   * are scanned sequentially in reorder mode. Otherwise, the rows are
+   * gathered by rowIdx_, with the rows prefetch_distance_ ahead being
+   * prefetched. Histogram kernels should
+   * iterate rows by this method.
+   * \param node tree node
+   * \param func callback function
+   */
+  template <typename Func>
+  inline void ForEachRow(const DTNode* node, Func func) {
+    ForEachRow(node, node->StartPos(), node->EndPos(), func);
+  }
+
+  /*!
+   * \brief Call func(row, y) on the rows [start_pos, end_pos] of the
+   * given node, which is a chunk of its rows. 
+   * \param node tree node
+   * \param start_pos start index of the chunk
+   * \param end_pos end index of the chunk
+   * \param func callback function
+   */
+  template <typename Func>
+  inline void ForEachRow(const DTNode* node,
+                         index_t start_pos,
+                         index_t end_pos,
+                         Func func) const {
+    if (reorder_data_) {
+      int buf = BufID(node);
+      const uint8* ptr = row_buf_[buf].data() + (uint64)start_pos * num_feat_;
+      const real_t* y = label_buf_[buf].data();
+      for (index_t i = start_pos; i <= end_pos; ++i) {
+        func(ptr, y[i]);
+        ptr += num_feat_;
+      }
+    } else {
+      index_t i = start_pos;
+      if (prefetch_distance_ > 0) {
+        index_t dist = prefetch_distance_;
+        for (; i + dist <= end_pos; ++i) {
+          PrefetchRow(rowIdx_[i + dist]);
+          index_t row_idx = rowIdx_[i];
+          func(X_ + (uint64)row_idx * num_feat_, Y_[row_idx]);
+        }
+      }
+      for (; i <= end_pos; ++i) {
+        index_t row_idx = rowIdx_[i];
+        func(X_ + (uint64)row_idx * num_feat_, Y_[row_idx]);
+      }
+    }
+  }
+
+  /*!
+   * \brief Number of chunks to split len rows into, which is 1 
+   * if there is no pool or the rows are too few.
+   */
+  inline index_t NumChunk(index_t len) const {
+    if (pool_ == nullptr) {
+      return 1;
+    }
+    // The waiting thread also runs tasks
+    index_t n_thread = pool_->ThreadNumber() + 1;
+    return std::max((index_t)1, std::min(len / min_chunk_rows_, n_thread));
+  }
+
+  /*!
+   * \brief Split [start_pos, end_pos] into n_chunk chunks, and call
+   * func(chunk_id, begin, end) on each chunk [begin, end] as a task
+   * of the pool. Return after all chunks are done.
+   */
+  template <typename Func>
+  inline void ParallelFor(index_t start_pos,
+                          index_t end_pos,
+                          index_t n_chunk,
+                          Func func) {
+    if (n_chunk <= 1) {
+      func(0, start_pos, end_pos);
+      return;
+    }
+    uint64 len = (uint64)end_pos - start_pos + 1;
+    TaskGroup group;
+    for (index_t c = 0; c < n_chunk; ++c) {
+      index_t begin = start_pos + len * c / n_chunk;
+      index_t end = start_pos + len * (c + 1) / n_chunk - 1;
+      pool_->Spawn(&group, [&func, c, begin, end]() {
+        func(c, begin, end);
+      });
+    }
+    pool_->Wait(&group);
+  }
 
   /*!
    * \breif Get leaf value.
@@ -490,8 +806,9 @@ class DTree {
   /*!
    * \breif Find best split position for current node.
    * \param node tree node
+   * \return false if we cannot find a valid split
    */
-  virtual void FindPosition(DTNode* node) = 0;
+  virtual bool FindPosition(DTNode* node) = 0;
 
   /*!
    * \breif If current node is a leaf node.
@@ -500,6 +817,42 @@ class DTree {
    */
   bool IsLeaf(DTNode* node);
 
+  /*!
+   * \brief If current node is a leaf node.
+   * \param node tree node
+   * \param len data size of current node
+   * \return true for Yes and false for No
+   */
+  bool IsLeaf(DTNode* node, index_t len);
+
+  /*!
+   * \brief Check wether the impurity decrease of the best split of
+   * current node is at least min_impurity_dec_, and then add the 
+   * decrease to the importance of the split feature.
+   * \param node tree node
+   * \param len data size of current node
+   * \param impurity impurity of current node
+   * \return true if the split is accepted
+   */
+  bool AcceptSplit(DTNode* node, index_t len, real_t impurity);
+
+  /*!
+   * \brief Use all of the data and features if
+   * SetRowIdx() and SetColIdx() are not called.
+   */
+  void InitSample();
+
+  /*!
+   * \brief Make current node a leaf node and clear its temp info.
+   * \param node tree node
+   */
+  void MakeLeaf(DTNode* node);
+
+  /*!
+   * \brief Copy the sampled rows into the reorder buffer.
+   */
+  void InitReorderBuffer();
+
   /*!
    * \breif Get a leaf node by given the data example.
    * \param node tree node
@@ -514,7 +867,37 @@ class DTree {
    */
   void SplitData(DTNode* node);
 
+  /*!
+   * \brief Serilize a sub-tree in pre-order.
+   */
+  void SerilizeNode(const DTNode* node, std::string* str);
+
+  /*!
+   * \brief Deserilize a sub-tree from str[*pos], and
+   * move *pos to the end of the sub-tree.
+   */
+  DTNode* DeserilizeNode(const std::string& str, size_t* pos);
+
+  /*!
+   * \brief Delete a sub-tree recursively.
+   * \param node root of the sub-tree
+   */
+  void DeleteNode(DTNode* node);
+
+  /*!
+   * \brief Delete the nodes and reset the counters of a trained
+   * tree, so that it can be built again.
+   */
+  void ResetTree();
+
+  /*!
+   * \brief Drop the statistics kept for the nodes of the tree, which
+   * is called whenever the nodes are deleted.
+   */
+  virtual void ClearNodeStat() {}
+
  private:
+  friend class TreeBatch;
   DISALLOW_COPY_AND_ASSIGN(DTree);
 };
 
@@ -548,8 +931,44 @@ struct Histogram {
   uint32_t* count = nullptr;
 };
 
-// Classification Tree
-class CDTree : public DTree {
+// Histogram count for binary-classification
+struct Count {
+  index_t count_0 = 0;
+  index_t count_1 = 0;
+};
+
+// Histogram for binary-classification
+class BHistogram : public HistoBase {
+ public:
+  BHistogram(const index_t num_feat,
+             const index_t num_bin) : num_bin(num_bin) {
+    count_len = num_feat;
+    count = new Count*[num_feat];
+    for (index_t i = 0; i < num_feat; ++i) {
+      count[i] = new Count[num_bin];
+    }
+  }
+  ~BHistogram() {
+    for (index_t i = 0; i < count_len; ++i) {
+      delete [] count[i];
+    }
+    delete [] count;
+  }
+  uint64 Bytes() const {
+    return sizeof(Count) * count_len * num_bin;
+  }
+  index_t total_0 = 0;
+  index_t total_1 = 0;
+  index_t num_bin = 0;
+  index_t count_len = 0;
+  Count** count = nullptr;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(BHistogram);
+};
+
+// Binary-classification Tree
+class BTree : public DTree {
  public:
   // ctor and dctor
   BTree() {}
@@ -564,13 +983,13 @@ class CDTree : public DTree {
               const real_t right_0, const real_t right_1);
 
   // Find best split position for current node
-  void FindPosition(DTNode* node);  
+  bool FindPosition(DTNode* node);  
 
   DISALLOW_COPY_AND_ASSIGN(BTree);
 };
 
 // Histogram for multi-classification
-class MCHistogram {
+class MCHistogram : public HistoBase {
  public:
   MCHistogram(const index_t num_feat,
               const index_t num_bin,
@@ -584,6 +1003,9 @@ class MCHistogram {
   ~MCHistogram() {
     delete [] count;
   }
+  uint64 Bytes() const {
+    return sizeof(index_t) * count_len;
+  }
   index_t count_len = 0;
   index_t* count = nullptr;
 
@@ -596,15 +1018,86 @@ class MCTree : public DTree {
  public:
   // ctor and dctor
   MCTree() {}
-  ~MCTree() {}
+  ~MCTree();
+
+  // Update tree by a mini-batch of new rows (Hoeffding tree). The new
+  // rows row_idx of batch are routed to the leaf nodes, whose histograms
+  // keep growing across mini-batches. A leaf node observing grace_period
+  // new rows is split if the gain of its best split is higher than the
+  // second best (of another feature) by the Hoeffding bound, or the bound
+  // is less than tie_threshold. A leaf node keeps its label (e.g., from
+  // the batch training) until the majority class of its new rows beats
+  // the label by the Hoeffding bound of label_confidence, and new leaf
+  // nodes start from the label of their parent in the same way. Note
+  // that each updated leaf node costs a histogram of the sampled features
+  // until it is split, and the histograms of a tree are bounded by
+  // max_online_histogram_bytes.
+  void Update(const Dataset& batch,
+              const std::vector<index_t>& row_idx,
+              const HyperParam& hyper_param);
+
+  // Bytes of the leaf histograms kept by Update()
+  inline uint64 OnlineBytes() const {
+    return online_bytes_;
+  }
 
  private:
+  // Statistics of a leaf node collected by Update()
+  struct LeafStat {
+    MCHistogram* histo = nullptr;
+    uint8 level = 1;
+    index_t len = 0;
+    index_t last_check = 0;
+  };
+  // Statistics of the leaf nodes reached by new rows
+  std::unordered_map<DTNode*, LeafStat> leaf_stat_;
+  // Bytes of the histograms in leaf_stat_
+  uint64 online_bytes_ = 0;
+  // Parameters of Hoeffding bound
+  real_t split_confidence_ = 1e-7;
+  real_t label_confidence_ = 0.01;
+  real_t tie_threshold_ = 0.05;
+
   // Get leaf value
   real_t LeafVal(const DTNode* node);
 
   // Find best split position for current node
-  void FindPosition(DTNode* node);  
+  bool FindPosition(DTNode* node);  
+
+  // Delete the leaf statistics of Update()
+  void ClearNodeStat();
+
+  // Find best split position from the histogram of current node
+  bool FindSplit(DTNode* node, const MCHistogram* histo, const index_t len);
+
+  // Sum total count of each class from histogram
+  void TotalCount(const MCHistogram* histo, std::vector<index_t>* total_count);
+
+  // Gini impurity of class counts
+  real_t Impurity(const std::vector<index_t>& total_count, const index_t len);
+
+  // Find best split of the j-th sampled feature, and 
+  // return its gini (kFloatMax if there is no valid split)
+  real_t FindFeatureSplit(const MCHistogram* histo,
+                          const index_t j,
+                          const std::vector<index_t>& total_count,
+                          const index_t len,
+                          uint8* best_bin);
+
+  // Split a leaf node if the Hoeffding bound is satisfied
+  void TryHoeffdingSplit(DTNode* node, LeafStat* stat);
+
+  // Majority class of the class counts of len rows if it beats the
+  // label by the Hoeffding bound, and the label otherwise
+  real_t OnlineLeafVal(const std::vector<index_t>& count, 
+                       const index_t len, 
+                       const real_t label);
+
+  // Drop the histograms of the leaf nodes with the fewest new rows
+  // (except node) until another histogram of bytes fits the budget
+  void EvictLeafStat(const DTNode* node, uint64 bytes, int64 budget);
 
+  friend class TreeBatch;
   DISALLOW_COPY_AND_ASSIGN(MCTree);
 };
 
@@ -632,7 +1125,7 @@ class RTree : public DTree {
   real_t LeafVal(const DTNode* node);
 
   // Find best split position for current node
-  void FindPosition(DTNode* node);  
+  bool FindPosition(DTNode* node);  
 
   DISALLOW_COPY_AND_ASSIGN(RTree);
 };
@@ -0,0 +1,362 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2018 by contributors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//------------------------------------------------------------------------------
+
+/*!
+*  Copyright (c) 2018 by Contributors
+* \file dtree_test.cc
+* \brief This file tests dtree.h file.
+*/
+#include "gtest/gtest.h"
+
+#include <string>
+#include <vector>
+#include <numeric>
+#include <random>
+
+#include "src/base/common.h"
+#include "src/tree/dtree.h"
+
+namespace xforest {
+
+static const index_t kNumFeat = 8;
+static const index_t kDataSize = 2000;
+static const uint8 kMaxBin = 63;
+
+// Generate a dataset with 3 classes,
+// which only depends on the first two features
+void GenData(std::vector<uint8>& X, std::vector<real_t>& Y) {
+  std::mt19937 rng(1231);
+  X.resize(kNumFeat * kDataSize);
+  Y.resize(kDataSize);
+  for (index_t i = 0; i < kDataSize; ++i) {
+    uint8* row = X.data() + i * kNumFeat;
+    for (index_t j = 0; j < kNumFeat; ++j) {
+      row[j] = rng() % (kMaxBin + 1);
+    }
+    Y[i] = (row[0] > 20 ? 1 : 0) + (row[1] > 40 ? 1 : 0);
+  }
+}
+
+HyperParam GetParam() {
+  HyperParam param;
+  param.max_bin = kMaxBin;
+  param.max_depth = 10;
+  param.max_leaf_nodes = 1000;
+  return param;
+}
+
+index_t Accuracy(DTree* tree,
+                 const std::vector<uint8>& X,
+                 const std::vector<real_t>& Y) {
+  index_t correct = 0;
+  for (index_t i = 0; i < kDataSize; ++i) {
+    if (tree->Predict(X.data() + i * kNumFeat) == Y[i]) {
+      correct++;
+    }
+  }
+  return correct;
+}
+
+TEST(DTreeTest, MCTree_train) {
+  std::vector<uint8> X;
+  std::vector<real_t> Y;
+  GenData(X, Y);
+  DTree* tree = CREATE_DTREE("mctree");
+  tree->Initialize(X.data(), Y.data(), 3, kNumFeat, kDataSize, GetParam());
+  tree->BuildTree();
+  EXPECT_EQ(Accuracy(tree, X, Y), kDataSize);
+  // Built again from scratch, including the counters
+  std::string str;
+  tree->Serilize(&str);
+  tree->BuildTree();
+  std::string new_str;
+  tree->Serilize(&new_str);
+  EXPECT_EQ(str, new_str);
+  delete tree;
+}
+
+TEST(DTreeTest, BTree_train) {
+  std::vector<uint8> X;
+  std::vector<real_t> Y;
+  GenData(X, Y);
+  for (index_t i = 0; i < kDataSize; ++i) {
+    Y[i] = Y[i] > 0 ? 1 : 0;
+  }
+  DTree* tree = CREATE_DTREE("btree");
+  tree->Initialize(X.data(), Y.data(), 2, kNumFeat, kDataSize, GetParam());
+  tree->BuildTree();
+  EXPECT_EQ(Accuracy(tree, X, Y), kDataSize);
+  delete tree;
+}
+
+TEST(DTreeTest, Reorder_data) {
+  std::vector<uint8> X;
+  std::vector<real_t> Y;
+  GenData(X, Y);
+  // Sample with duplicates
+  std::vector<index_t> row_idx;
+  for (index_t i = 0; i < kDataSize; i += 3) {
+    row_idx.push_back(i);
+    row_idx.push_back(i);
+  }
+  HyperParam param = GetParam();
+  param.max_depth = 5;
+  DTree* tree = CREATE_DTREE("mctree");
+  tree->Initialize(X.data(), Y.data(), 3, kNumFeat, kDataSize, param);
+  tree->SetRowIdx(row_idx);
+  tree->BuildTree();
+  param.reorder_data = true;
+  DTree* reorder_tree = CREATE_DTREE("mctree");
+  reorder_tree->Initialize(X.data(), Y.data(), 3, kNumFeat, kDataSize, param);
+  reorder_tree->SetRowIdx(row_idx);
+  reorder_tree->BuildTree();
+  for (index_t i = 0; i < kDataSize; ++i) {
+    const uint8* x = X.data() + i * kNumFeat;
+    EXPECT_EQ(tree->Predict(x), reorder_tree->Predict(x));
+  }
+  delete tree;
+  delete reorder_tree;
+}
+
+TEST(DTreeTest, Histogram_cache) {
+  std::vector<uint8> X;
+  std::vector<real_t> Y;
+  GenData(X, Y);
+  HyperParam param = GetParam();
+  DTree* tree = CREATE_DTREE("mctree");
+  tree->Initialize(X.data(), Y.data(), 3, kNumFeat, kDataSize, param);
+  tree->BuildTree();
+  EXPECT_EQ(tree->HistoCache().Evictions(), 0);
+  // Budget of two histograms
+  uint64 histo_bytes = sizeof(index_t) * kNumFeat * (kMaxBin + 1) * 3;
+  param.max_histogram_bytes = histo_bytes * 2;
+  DTree* small_tree = CREATE_DTREE("mctree");
+  small_tree->Initialize(X.data(), Y.data(), 3, kNumFeat, kDataSize, param);
+  small_tree->BuildTree();
+  EXPECT_GT(small_tree->HistoCache().Evictions(), 0);
+  EXPECT_LE(small_tree->HistoCache().PeakBytes(), histo_bytes * 3);
+  for (index_t i = 0; i < kDataSize; ++i) {
+    const uint8* x = X.data() + i * kNumFeat;
+    EXPECT_EQ(tree->Predict(x), small_tree->Predict(x));
+  }
+  delete tree;
+  delete small_tree;
+}
+
+TEST(DTreeTest, Grow_policy) {
+  std::vector<uint8> X;
+  std::vector<real_t> Y;
+  GenData(X, Y);
+  // Noisy labels to grow a deep tree
+  for (index_t i = 0; i < kDataSize; i += 7) {
+    Y[i] = (Y[i] + 1) - (Y[i] == 2 ? 3 : 0);
+  }
+  HyperParam param = GetParam();
+  param.max_depth = 30;
+  param.reorder_data = true;
+  DTree* tree = CREATE_DTREE("mctree");
+  tree->Initialize(X.data(), Y.data(), 3, kNumFeat, kDataSize, param);
+  tree->BuildTree();
+  uint64 bfs_peak = tree->HistoCache().PeakBytes();
+  for (std::string policy : { "depth_first", "hybrid" }) {
+    param.grow_policy = policy;
+    param.hybrid_depth = 3;
+    DTree* dfs_tree = CREATE_DTREE("mctree");
+    dfs_tree->Initialize(X.data(), Y.data(), 3, kNumFeat, kDataSize, param);
+    dfs_tree->BuildTree();
+    EXPECT_LT(dfs_tree->HistoCache().PeakBytes(), bfs_peak);
+    for (index_t i = 0; i < kDataSize; ++i) {
+      const uint8* x = X.data() + i * kNumFeat;
+      EXPECT_EQ(tree->Predict(x), dfs_tree->Predict(x));
+    }
+    delete dfs_tree;
+  }
+  delete tree;
+}
+
+TEST(DTreeTest, Prefetch) {
+  std::vector<uint8> X;
+  std::vector<real_t> Y;
+  GenData(X, Y);
+  int dist = DTree::CalibratePrefetchDistance(X.data(), kNumFeat, kDataSize);
+  EXPECT_GE(dist, 0);
+  EXPECT_LE(dist, 64);
+  // Cached for the row width and working set
+  int cached_dist = DTree::PrefetchDistance(X.data(), kNumFeat, kDataSize);
+  EXPECT_EQ(DTree::PrefetchDistance(X.data(), kNumFeat, 1), cached_dist);
+  EXPECT_EQ(DTree::WorkingSetBucket(kNumFeat, kDataSize), 0);
+  // Datasets larger than the LLC do not share the distance
+  int bucket = DTree::WorkingSetBucket(kNumFeat, kInt32Max);
+  EXPECT_GT(bucket, 0);
+  EXPECT_LT(DTree::WorkingSetBucket(kNumFeat, kInt32Max / 4), bucket);
+  HyperParam param = GetParam();
+  param.prefetch_distance = 0;
+  DTree* tree = CREATE_DTREE("mctree");
+  tree->Initialize(X.data(), Y.data(), 3, kNumFeat, kDataSize, param);
+  tree->BuildTree();
+  param.prefetch_distance = 8;
+  DTree* prefetch_tree = CREATE_DTREE("mctree");
+  prefetch_tree->Initialize(X.data(), Y.data(), 3, kNumFeat, kDataSize, param);
+  prefetch_tree->BuildTree();
+  for (index_t i = 0; i < kDataSize; ++i) {
+    const uint8* x = X.data() + i * kNumFeat;
+    EXPECT_EQ(tree->Predict(x), prefetch_tree->Predict(x));
+  }
+  delete tree;
+  delete prefetch_tree;
+}
+
+TEST(DTreeTest, Parallel_node) {
+  std::vector<uint8> X;
+  std::vector<real_t> Y;
+  GenData(X, Y);
+  WorkStealingPool pool(3);
+  for (int reorder = 0; reorder < 2; ++reorder) {
+    HyperParam param = GetParam();
+    param.reorder_data = reorder;
+    DTree* tree = CREATE_DTREE("mctree");
+    tree->Initialize(X.data(), Y.data(), 3, kNumFeat, kDataSize, param);
+    tree->BuildTree();
+    // Nodes with at least 200 rows are split into chunks
+    DTree* parallel_tree = CREATE_DTREE("mctree");
+    parallel_tree->Initialize(X.data(), Y.data(), 3, 
+                              kNumFeat, kDataSize, param);
+    parallel_tree->SetPool(&pool, 100);
+    parallel_tree->BuildTree();
+    for (index_t i = 0; i < kDataSize; ++i) {
+      const uint8* x = X.data() + i * kNumFeat;
+      EXPECT_EQ(tree->Predict(x), parallel_tree->Predict(x));
+    }
+    delete tree;
+    delete parallel_tree;
+  }
+}
+
+TEST(DTreeTest, Serilize) {
+  std::vector<uint8> X;
+  std::vector<real_t> Y;
+  GenData(X, Y);
+  DTree* tree = CREATE_DTREE("mctree");
+  tree->Initialize(X.data(), Y.data(), 3, kNumFeat, kDataSize, GetParam());
+  tree->BuildTree();
+  std::string str;
+  tree->Serilize(&str);
+  DTree* new_tree = CREATE_DTREE("mctree");
+  new_tree->Deserilize(str);
+  for (index_t i = 0; i < kDataSize; ++i) {
+    const uint8* x = X.data() + i * kNumFeat;
+    EXPECT_EQ(tree->Predict(x), new_tree->Predict(x));
+  }
+  std::string new_str;
+  new_tree->Serilize(&new_str);
+  EXPECT_EQ(str, new_str);
+  delete tree;
+  delete new_tree;
+}
+
+TEST(DTreeTest, Feature_importances) {
+  std::vector<uint8> X;
+  std::vector<real_t> Y;
+  GenData(X, Y);
+  DTree* tree = CREATE_DTREE("mctree");
+  tree->Initialize(X.data(), Y.data(), 3, kNumFeat, kDataSize, GetParam());
+  tree->BuildTree();
+  const std::vector<real_t>& importances = tree->FeatureImportances();
+  EXPECT_EQ(importances.size(), kNumFeat);
+  // Label only depends on the first two features, and
+  // all of the impurity are removed by the splits
+  EXPECT_GT(importances[0], 0.0);
+  EXPECT_GT(importances[1], 0.0);
+  for (index_t j = 2; j < kNumFeat; ++j) {
+    EXPECT_EQ(importances[j], 0.0);
+  }
+  real_t impurity = 1.0;
+  std::vector<index_t> count(3, 0);
+  for (real_t y : Y) {
+    count[(index_t)y]++;
+  }
+  for (index_t c : count) {
+    impurity -= ((real_t)c / kDataSize) * ((real_t)c / kDataSize);
+  }
+  EXPECT_NEAR(importances[0] + importances[1], impurity, 1e-4);
+  delete tree;
+}
+
+TEST(DTreeTest, Online_update) {
+  std::vector<uint8> X;
+  std::vector<real_t> Y;
+  GenData(X, Y);
+  // Train with the first 20 rows
+  HyperParam param = GetParam();
+  param.grace_period = 50;
+  MCTree tree;
+  tree.Initialize(X.data(), Y.data(), 3, kNumFeat, 20, param);
+  tree.BuildTree();
+  index_t correct = Accuracy(&tree, X, Y);
+  EXPECT_LT(correct, kDataSize * 0.9);
+  // Stream the other rows in mini-batches of 100 rows
+  for (index_t begin = 20; begin + 100 <= kDataSize; begin += 100) {
+    Dataset batch(std::vector<uint8>(X.begin() + begin * kNumFeat,
+                                     X.begin() + (begin + 100) * kNumFeat),
+                  std::vector<real_t>(Y.begin() + begin, 
+                                      Y.begin() + begin + 100),
+                  3, kNumFeat, kMaxBin);
+    std::vector<index_t> row_idx(100);
+    std::iota(row_idx.begin(), row_idx.end(), 0);
+    tree.Update(batch, row_idx, param);
+  }
+  EXPECT_GT(Accuracy(&tree, X, Y), kDataSize * 0.8);
+}
+
+TEST(DTreeTest, Online_update_label) {
+  std::vector<uint8> X;
+  std::vector<real_t> Y;
+  GenData(X, Y);
+  HyperParam param = GetParam();
+  MCTree tree;
+  tree.Initialize(X.data(), Y.data(), 3, kNumFeat, kDataSize, param);
+  tree.BuildTree();
+  EXPECT_EQ(Accuracy(&tree, X, Y), kDataSize);
+  // A few rows of random labels keep the labels from the batch training
+  std::mt19937 rng(7);
+  std::vector<real_t> noise(100);
+  for (real_t& y : noise) {
+    y = rng() % 3;
+  }
+  Dataset batch(std::vector<uint8>(X.begin(), X.begin() + 100 * kNumFeat),
+                noise, 3, kNumFeat, kMaxBin);
+  std::vector<index_t> row_idx(100);
+  std::iota(row_idx.begin(), row_idx.end(), 0);
+  param.grace_period = 10;
+  // Keep a single leaf histogram
+  param.max_online_histogram_bytes = 
+    sizeof(index_t) * kNumFeat * (kMaxBin + 1) * 3;
+  tree.Update(batch, row_idx, param);
+  EXPECT_LE(tree.OnlineBytes(), (uint64)param.max_online_histogram_bytes);
+  EXPECT_GT(Accuracy(&tree, X, Y), kDataSize * 0.95);
+  // The histograms of the old nodes are dropped with them
+  EXPECT_GT(tree.OnlineBytes(), 0);
+  std::string str;
+  tree.Serilize(&str);
+  tree.Deserilize(str);
+  EXPECT_EQ(tree.OnlineBytes(), 0);
+  tree.Update(batch, row_idx, param);
+  EXPECT_GT(tree.OnlineBytes(), 0);
+  tree.BuildTree();
+  EXPECT_EQ(tree.OnlineBytes(), 0);
+}
+
+}  // namespace xforest
@@ -0,0 +1,288 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2018 by contributors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//------------------------------------------------------------------------------
+
+/*
+This file is the implementation of FlatTree class.
+*/
+
+#include "src/tree/flat_tree.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define XFOREST_X86_SIMD
+#endif
+
+namespace xforest {
+
+// Flatten a tree
+void FlatTree::Flatten(const DTree& tree) {
+  CHECK_NOTNULL(tree.Root());
+  nodes_.clear();
+  FlattenNode(tree.Root());
+  std::vector<FlatNode>(nodes_).swap(nodes_);
+}
+
+// Append a sub-tree in pre-order
+void FlatTree::FlattenNode(const DTNode* node) {
+  CHECK_LT(nodes_.size(), kIndexMask);
+  size_t id = nodes_.size();
+  nodes_.emplace_back();
+  if (node->IsLeaf()) {
+    memcpy(&nodes_[id].split, &node->leaf_val, sizeof(real_t));
+    nodes_[id].child = kLeafFlag;
+    return;
+  }
+  CHECK_LT(node->BestFeatID(), kMaxFeat);
+  nodes_[id].split = (node->BestFeatID() << 8) | node->BestBinVal();
+  // Hot child is the next node
+  if (node->HotRight()) {
+    FlattenNode(node->RightChild());
+    nodes_[id].child = nodes_.size() | kHotRight;
+    FlattenNode(node->LeftChild());
+  } else {
+    FlattenNode(node->LeftChild());
+    nodes_[id].child = nodes_.size();
+    FlattenNode(node->RightChild());
+  }
+}
+
+#ifdef XFOREST_X86_SIMD
+
+// Whether the 4-byte gathers of rows [i, i + width) stay in X
+static inline bool InBound(index_t i, index_t width, 
+                           index_t num_feat, index_t n) {
+  return i + width <= n && (uint64)(n - i - width) * num_feat >= 3;
+}
+
+// One level of 8 rows in lockstep, and return false if all of
+// the rows reach a leaf node
+__attribute__((target("avx2"), always_inline))
+static inline bool StepAVX2(const int* split_ptr,
+                            const int* x,
+                            __m256i row_off,
+                            __m256i* idx) {
+  const __m256i leaf_flag = _mm256_set1_epi32(FlatTree::kLeafFlag);
+  const __m256i index_mask = _mm256_set1_epi32(FlatTree::kIndexMask);
+  const __m256i byte_mask = _mm256_set1_epi32(0xFF);
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i child = _mm256_i32gather_epi32(split_ptr + 1, *idx, 8);
+  // Sign bit is set for the split nodes
+  __m256i inner = _mm256_andnot_si256(child, leaf_flag);
+  if (_mm256_testz_si256(inner, inner)) {
+    return false;
+  }
+  __m256i split = _mm256_i32gather_epi32(split_ptr, *idx, 8);
+  __m256i feat = _mm256_srli_epi32(split, 8);
+  __m256i bin = _mm256_and_si256(split, byte_mask);
+  __m256i val = _mm256_mask_i32gather_epi32(zero, x, 
+    _mm256_add_epi32(row_off, feat), inner, 1);
+  val = _mm256_and_si256(val, byte_mask);
+  __m256i right = _mm256_cmpgt_epi32(val, bin);
+  // Sign bit of hot is set if the hot child is the right one
+  __m256i hot = _mm256_slli_epi32(child, 1);
+  __m256 next = _mm256_blendv_ps(
+    _mm256_castsi256_ps(_mm256_add_epi32(*idx, _mm256_set1_epi32(1))),
+    _mm256_castsi256_ps(_mm256_and_si256(child, index_mask)),
+    _mm256_castsi256_ps(_mm256_xor_si256(right, hot)));
+  *idx = _mm256_castps_si256(_mm256_blendv_ps(
+    _mm256_castsi256_ps(*idx), next, _mm256_castsi256_ps(inner)));
+  return true;
+}
+
+// Walk two groups of 8 rows in lockstep, so that the gathers of one
+// group hide the latency of the other, and return the first row not
+// predicted
+__attribute__((target("avx2")))
+static index_t PredictRowsAVX2(const FlatNode* nodes,
+                               const uint8* X,
+                               index_t num_feat,
+                               index_t n,
+                               real_t* Y) {
+  const int* split_ptr = (const int*)nodes;
+  const __m256i row_off = _mm256_mullo_epi32(
+    _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), 
+    _mm256_set1_epi32(num_feat));
+  const __m256i zero = _mm256_setzero_si256();
+  index_t i = 0;
+  for (; InBound(i, 16, num_feat, n); i += 16) {
+    const int* x_0 = (const int*)(X + (uint64)i * num_feat);
+    const int* x_1 = (const int*)(X + (uint64)(i + 8) * num_feat);
+    __m256i idx_0 = zero;
+    __m256i idx_1 = zero;
+    bool inner_0 = true;
+    bool inner_1 = true;
+    while (inner_0 || inner_1) {
+      inner_0 = inner_0 && StepAVX2(split_ptr, x_0, row_off, &idx_0);
+      inner_1 = inner_1 && StepAVX2(split_ptr, x_1, row_off, &idx_1);
+    }
+    // Leaf values are stored in the split words
+    __m256i leaf_0 = _mm256_i32gather_epi32(split_ptr, idx_0, 8);
+    __m256i leaf_1 = _mm256_i32gather_epi32(split_ptr, idx_1, 8);
+    _mm256_storeu_ps(Y + i, _mm256_castsi256_ps(leaf_0));
+    _mm256_storeu_ps(Y + i + 8, _mm256_castsi256_ps(leaf_1));
+  }
+  return i;
+}
+
+// One level of 16 rows in lockstep, and return false if all of
+// the rows reach a leaf node
+__attribute__((target("avx512f"), always_inline))
+static inline bool StepAVX512(const int* split_ptr,
+                              const int* x,
+                              __m512i row_off,
+                              __m512i* idx) {
+  const __m512i leaf_flag = _mm512_set1_epi32(FlatTree::kLeafFlag);
+  const __m512i hot_right = _mm512_set1_epi32(FlatTree::kHotRight);
+  const __m512i index_mask = _mm512_set1_epi32(FlatTree::kIndexMask);
+  const __m512i byte_mask = _mm512_set1_epi32(0xFF);
+  const __m512i zero = _mm512_setzero_si512();
+  __m512i child = _mm512_mask_i32gather_epi32(zero, 0xFFFF, *idx,
+                                              split_ptr + 1, 8);
+  __mmask16 inner = _mm512_testn_epi32_mask(child, leaf_flag);
+  if (inner == 0) {
+    return false;
+  }
+  __m512i split = _mm512_mask_i32gather_epi32(zero, 0xFFFF, *idx,
+                                              split_ptr, 8);
+  __m512i feat = _mm512_maskz_srli_epi32(inner, split, 8);
+  __m512i bin = _mm512_and_si512(split, byte_mask);
+  __m512i val = _mm512_mask_i32gather_epi32(zero, inner,
+    _mm512_add_epi32(row_off, feat), x, 1);
+  val = _mm512_and_si512(val, byte_mask);
+  __mmask16 right = _mm512_mask_cmpgt_epi32_mask(inner, val, bin);
+  __mmask16 hot = _mm512_mask_test_epi32_mask(inner, child, hot_right);
+  __mmask16 cold = right ^ hot;
+  *idx = _mm512_mask_add_epi32(*idx, inner & ~cold, *idx, 
+                               _mm512_set1_epi32(1));
+  *idx = _mm512_mask_and_epi32(*idx, cold, child, index_mask);
+  return true;
+}
+
+// Walk two groups of 16 rows in lockstep, and return the
+// first row not predicted
+__attribute__((target("avx512f")))
+static index_t PredictRowsAVX512(const FlatNode* nodes,
+                                 const uint8* X,
+                                 index_t num_feat,
+                                 index_t n,
+                                 real_t* Y) {
+  const int* split_ptr = (const int*)nodes;
+  const __m512i row_off = _mm512_mullo_epi32(
+    _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7,
+                      8, 9, 10, 11, 12, 13, 14, 15),
+    _mm512_set1_epi32(num_feat));
+  const __m512i zero = _mm512_setzero_si512();
+  index_t i = 0;
+  for (; InBound(i, 32, num_feat, n); i += 32) {
+    const int* x_0 = (const int*)(X + (uint64)i * num_feat);
+    const int* x_1 = (const int*)(X + (uint64)(i + 16) * num_feat);
+    __m512i idx_0 = zero;
+    __m512i idx_1 = zero;
+    bool inner_0 = true;
+    bool inner_1 = true;
+    while (inner_0 || inner_1) {
+      inner_0 = inner_0 && StepAVX512(split_ptr, x_0, row_off, &idx_0);
+      inner_1 = inner_1 && StepAVX512(split_ptr, x_1, row_off, &idx_1);
+    }
+    // Leaf values are stored in the split words
+    __m512i leaf_0 = _mm512_mask_i32gather_epi32(zero, 0xFFFF, idx_0,
+                                                 split_ptr, 8);
+    __m512i leaf_1 = _mm512_mask_i32gather_epi32(zero, 0xFFFF, idx_1,
+                                                 split_ptr, 8);
+    _mm512_storeu_ps(Y + i, _mm512_castsi512_ps(leaf_0));
+    _mm512_storeu_ps(Y + i + 16, _mm512_castsi512_ps(leaf_1));
+  }
+  return i;
+}
+
+#endif  // XFOREST_X86_SIMD
+
+// Check CPU features
+bool FlatTree::Supports(Kernel kernel) {
+  switch (kernel) {
+    case kAuto:
+    case kScalar:
+      return true;
+#ifdef XFOREST_X86_SIMD
+    case kAVX2:
+      return __builtin_cpu_supports("avx2");
+    case kAVX512:
+      return __builtin_cpu_supports("avx512f");
+#endif
+    default:
+      return false;
+  }
+}
+
+// Runtime CPU dispatch
+FlatTree::Kernel FlatTree::BestKernel() {
+  static const Kernel kernel = Supports(kAVX512) ? kAVX512 :
+                               Supports(kAVX2) ? kAVX2 : kScalar;
+  return kernel;
+}
+
+// Predict contiguous rows
+void FlatTree::PredictRows(const uint8* X,
+                           index_t num_feat,
+                           index_t n,
+                           real_t* Y,
+                           Kernel kernel) const {
+  CHECK_NOTNULL(X);
+  CHECK_NOTNULL(Y);
+  CHECK(!nodes_.empty());
+  if (kernel == kAuto) {
+    kernel = BestKernel();
+  }
+  if (!Supports(kernel)) {
+    LOG(FATAL) << "Kernel " << kernel << " is not supported by the CPU";
+  }
+  index_t i = 0;
+#ifdef XFOREST_X86_SIMD
+  if (kernel == kAVX512) {
+    i = PredictRowsAVX512(nodes_.data(), X, num_feat, n, Y);
+  } else if (kernel == kAVX2) {
+    i = PredictRowsAVX2(nodes_.data(), X, num_feat, n, Y);
+  }
+#endif
+  // Interleave the independent walks of 8 rows
+  const FlatNode* nodes = nodes_.data();
+  for (; i + 8 <= n; i += 8) {
+    const uint8* x = X + (uint64)i * num_feat;
+    uint32 idx[8] = { 0 };
+    bool inner = true;
+    while (inner) {
+      inner = false;
+      for (int r = 0; r < 8; ++r) {
+        const FlatNode& node = nodes[idx[r]];
+        if (node.child & kLeafFlag) {
+          continue;
+        }
+        inner = true;
+        uint32 split = node.split;
+        idx[r] = NextNode(idx[r], node.child, 
+                          x[r * num_feat + (split >> 8)] > (split & 0xFF));
+      }
+    }
+    for (int r = 0; r < 8; ++r) {
+      Y[i + r] = LeafVal(nodes[idx[r]]);
+    }
+  }
+  for (; i < n; ++i) {
+    Y[i] = Predict(X + (uint64)i * num_feat);
+  }
+}
+
+}  // namespace xforest
@@ -0,0 +1,194 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2018 by contributors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//------------------------------------------------------------------------------
+
+/*!
+*  Copyright (c) 2018 by Contributors
+* \file flat_tree.h
+* \brief This file defines the FlatTree class, which is an
+* inference-only layout of a decision tree.
+*/
+#ifndef XFOREST_TREE_FLAT_TREE_H_
+#define XFOREST_TREE_FLAT_TREE_H_
+
+#include <string.h>
+
+#include <vector>
+
+#include "src/base/common.h"
+#include "src/tree/dtree.h"
+
+namespace xforest {
+
+/*!
+* \brief A node of FlatTree packed in 8 bytes.
+*/
+struct FlatNode {
+  /*! \brief Split feature id (high 24 bits) and split bin
+   * value (low 8 bits), or the leaf value of a leaf node */
+  uint32 split;
+  /*! \brief Index of the cold child and kHotRight, or kLeafFlag */
+  uint32 child;
+};
+
+static_assert(sizeof(FlatNode) == 8, "FlatNode must be 8 bytes");
+
+/*!
+* \brief FlatTree stores the nodes of a trained tree in one contiguous
+* array in pre-order, where each split node is followed by its hot child,
+* i.e., the child taken by more training rows (see DTNode::HotRight()),
+* and only the index of the other (cold) child is stored. Predict() walks
+* the array iteratively, and the typical root-to-leaf paths run forward
+* through a few cache lines instead of chasing DTNode pointers across
+* the heap. Basic usage:
+*
+*   FlatTree flat_tree;
+*   flat_tree.Flatten(*tree);
+*   real_t y = flat_tree.Predict(x);
+*
+* The tree is copied, so it can be deleted or updated afterwards. The
+* feature id must be less than 2^24.
+*/
+class FlatTree {
+ public:
+  /*!
+  * \brief Constructor and Destructor
+  */
+  FlatTree() { }
+  ~FlatTree() { }
+
+  /*! \brief Leaf flag of FlatNode::child */
+  static const uint32 kLeafFlag = 0x80000000u;
+  /*! \brief Flag of FlatNode::child if the hot child is the right one */
+  static const uint32 kHotRight = 0x40000000u;
+  /*! \brief Mask of the cold child index in FlatNode::child */
+  static const uint32 kIndexMask = 0x3FFFFFFFu;
+  /*! \brief Maximal feature id + 1 */
+  static const index_t kMaxFeat = 1u << 24;
+
+  /*!
+  * \brief Build the flat layout of a trained (or deserilized) tree.
+  * \param tree decision tree
+  */
+  void Flatten(const DTree& tree);
+
+  /*!
+  * \brief Given data x, predict label y.
+  * \param x pointer of data example
+  * \return predicted value y
+  */
+  inline real_t Predict(const uint8* x) const {
+    return LeafVal(nodes_[GetLeaf(x)]);
+  }
+
+  /*!
+  * \brief Kernel of PredictRows().
+  */
+  enum Kernel {
+    kAuto = 0,
+    kScalar,
+    kAVX2,
+    kAVX512
+  };
+
+  /*!
+  * \brief The fastest kernel supported by current CPU.
+  */
+  static Kernel BestKernel();
+
+  /*!
+  * \brief Wether current CPU supports the kernel.
+  */
+  static bool Supports(Kernel kernel);
+
+  /*!
+  * \brief Predict n contiguous rows by this tree. The SIMD kernels walk
+  * 8 (AVX2) or 16 (AVX-512) rows through the tree in lockstep, which
+  * gather their nodes and feature bytes at each level until all of the
+  * rows reach a leaf node. Two such groups are interleaved to hide the
+  * latency of the gathers. The scalar kernel interleaves the walks of
+  * 8 rows in the same way. The last few rows are left to the scalar
+  * kernel, so that the 4-byte gathers do not read past the end of X.
+  * \param X pointer of data examples (n * num_feat)
+  * \param num_feat number of feature
+  * \param n number of rows
+  * \param Y predicted values of n rows
+  * \param kernel kernel to use, kAuto for BestKernel()
+  */
+  void PredictRows(const uint8* X,
+                   index_t num_feat,
+                   index_t n,
+                   real_t* Y,
+                   Kernel kernel = kAuto) const;
+
+  /*!
+  * \brief Index of the leaf node of data x.
+  */
+  inline uint32 GetLeaf(const uint8* x) const {
+    const FlatNode* nodes = nodes_.data();
+    uint32 i = 0;
+    while (!(nodes[i].child & kLeafFlag)) {
+      uint32 split = nodes[i].split;
+      i = NextNode(i, nodes[i].child, x[split >> 8] > (split & 0xFF));
+    }
+    return i;
+  }
+
+  /*!
+  * \brief Index of the child of split node i.
+  * \param i index of the split node
+  * \param child child word of the split node
+  * \param right wether to go to the right child
+  */
+  static inline uint32 NextNode(uint32 i, uint32 child, bool right) {
+    return right == ((child & kHotRight) != 0) ? i + 1 : child & kIndexMask;
+  }
+
+  /*!
+  * \brief Leaf value of a leaf node.
+  */
+  static inline real_t LeafVal(const FlatNode& node) {
+    real_t val;
+    memcpy(&val, &node.split, sizeof(real_t));
+    return val;
+  }
+
+  /*!
+  * \brief Nodes in pre-order.
+  */
+  inline const std::vector<FlatNode>& Nodes() const {
+    return nodes_;
+  }
+
+  /*!
+  * \brief Number of nodes.
+  */
+  inline size_t NumNode() const {
+    return nodes_.size();
+  }
+
+ protected:
+  /*! \brief Nodes in pre-order */
+  std::vector<FlatNode> nodes_;
+
+  /*!
+  * \brief Append a sub-tree in pre-order.
+  */
+  void FlattenNode(const DTNode* node);
+};
+
+}  // namespace xforest
+
+#endif  // XFOREST_TREE_FLAT_TREE_H_
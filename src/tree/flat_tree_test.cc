@@ -0,0 +1,163 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2018 by contributors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//------------------------------------------------------------------------------
+
+/*!
+*  Copyright (c) 2018 by Contributors
+* \file flat_tree_test.cc
+* \brief This file tests flat_tree.h file.
+*/
+#include "gtest/gtest.h"
+
+#include <vector>
+
+#include "src/base/common.h"
+#include "src/tree/flat_tree.h"
+#include "src/tree/test_util.h"
+
+namespace xforest {
+
+static const index_t kNumFeat = 8;
+static const index_t kDataSize = 2000;
+
+TEST(FlatTreeTest, Predict) {
+  std::vector<uint8> X;
+  std::vector<real_t> Y;
+  GenData(kNumFeat, kDataSize, X, Y);
+  DTree* tree = CREATE_DTREE("mctree");
+  tree->Initialize(X.data(), Y.data(), 3, kNumFeat, kDataSize, GetParam());
+  tree->BuildTree();
+  FlatTree flat_tree;
+  flat_tree.Flatten(*tree);
+  EXPECT_GT(flat_tree.NumNode(), 1);
+  EXPECT_EQ(flat_tree.NumNode() % 2, 1);
+  for (index_t i = 0; i < kDataSize; ++i) {
+    const uint8* x = X.data() + i * kNumFeat;
+    EXPECT_EQ(tree->Predict(x), flat_tree.Predict(x));
+  }
+  // Deserilized tree
+  std::string str;
+  tree->Serilize(&str);
+  DTree* new_tree = CREATE_DTREE("mctree");
+  new_tree->Deserilize(str);
+  FlatTree new_flat_tree;
+  new_flat_tree.Flatten(*new_tree);
+  for (index_t i = 0; i < kDataSize; ++i) {
+    const uint8* x = X.data() + i * kNumFeat;
+    EXPECT_EQ(tree->Predict(x), new_flat_tree.Predict(x));
+  }
+  delete tree;
+  delete new_tree;
+}
+
+TEST(FlatTreeTest, Predict_rows) {
+  std::vector<uint8> X;
+  std::vector<real_t> Y;
+  GenData(kNumFeat, kDataSize, X, Y);
+  DTree* tree = CREATE_DTREE("mctree");
+  tree->Initialize(X.data(), Y.data(), 3, kNumFeat, kDataSize, GetParam());
+  tree->BuildTree();
+  FlatTree flat_tree;
+  flat_tree.Flatten(*tree);
+  for (FlatTree::Kernel kernel : { FlatTree::kAuto, FlatTree::kScalar,
+                                   FlatTree::kAVX2, FlatTree::kAVX512 }) {
+    if (!FlatTree::Supports(kernel)) {
+      continue;
+    }
+    // The number of rows is not a multiple of the group size
+    for (index_t n : { 1, 15, 16, 17, 33, 64, 999 }) {
+      std::vector<real_t> pred(n, -1);
+      flat_tree.PredictRows(X.data(), kNumFeat, n, pred.data(), kernel);
+      for (index_t i = 0; i < n; ++i) {
+        EXPECT_EQ(pred[i], flat_tree.Predict(X.data() + i * kNumFeat));
+      }
+    }
+  }
+  delete tree;
+}
+
+TEST(FlatTreeTest, Hot_child) {
+  std::vector<uint8> X;
+  std::vector<real_t> Y;
+  GenData(kNumFeat, kDataSize, X, Y);
+  DTree* tree = CREATE_DTREE("mctree");
+  tree->Initialize(X.data(), Y.data(), 3, kNumFeat, kDataSize, GetParam());
+  tree->BuildTree();
+  FlatTree flat_tree;
+  flat_tree.Flatten(*tree);
+  // Count the training rows visiting each node
+  const std::vector<FlatNode>& nodes = flat_tree.Nodes();
+  std::vector<index_t> visit(nodes.size(), 0);
+  for (index_t i = 0; i < kDataSize; ++i) {
+    const uint8* x = X.data() + i * kNumFeat;
+    uint32 k = 0;
+    visit[k]++;
+    while (!(nodes[k].child & FlatTree::kLeafFlag)) {
+      uint32 split = nodes[k].split;
+      k = FlatTree::NextNode(k, nodes[k].child, 
+                             x[split >> 8] > (split & 0xFF));
+      visit[k]++;
+    }
+  }
+  // The next node is taken by more rows
+  index_t num_hot_right = 0;
+  for (size_t k = 0; k < nodes.size(); ++k) {
+    if (nodes[k].child & FlatTree::kLeafFlag) {
+      continue;
+    }
+    uint32 cold = nodes[k].child & FlatTree::kIndexMask;
+    EXPECT_GE(visit[k + 1], visit[cold]);
+    EXPECT_EQ(visit[k + 1] + visit[cold], visit[k]);
+    if (nodes[k].child & FlatTree::kHotRight) {
+      num_hot_right++;
+    }
+  }
+  EXPECT_GT(num_hot_right, 0);
+  // Hot children are kept by serilization
+  std::string str;
+  tree->Serilize(&str);
+  DTree* new_tree = CREATE_DTREE("mctree");
+  new_tree->Deserilize(str);
+  FlatTree new_flat_tree;
+  new_flat_tree.Flatten(*new_tree);
+  ASSERT_EQ(new_flat_tree.NumNode(), flat_tree.NumNode());
+  for (size_t k = 0; k < nodes.size(); ++k) {
+    EXPECT_EQ(new_flat_tree.Nodes()[k].split, nodes[k].split);
+    EXPECT_EQ(new_flat_tree.Nodes()[k].child, nodes[k].child);
+  }
+  delete tree;
+  delete new_tree;
+}
+
+TEST(FlatTreeTest, Single_leaf) {
+  std::vector<uint8> X;
+  std::vector<real_t> Y;
+  GenData(kNumFeat, kDataSize, X, Y);
+  // Pure node is not split
+  Y.assign(kDataSize, 2);
+  DTree* tree = CREATE_DTREE("mctree");
+  tree->Initialize(X.data(), Y.data(), 3, kNumFeat, kDataSize, GetParam());
+  tree->BuildTree();
+  FlatTree flat_tree;
+  flat_tree.Flatten(*tree);
+  EXPECT_EQ(flat_tree.NumNode(), 1);
+  EXPECT_EQ(flat_tree.Predict(X.data()), 2);
+  std::vector<real_t> pred(kDataSize, -1);
+  flat_tree.PredictRows(X.data(), kNumFeat, kDataSize, pred.data());
+  EXPECT_EQ(pred, std::vector<real_t>(kDataSize, 2));
+  delete tree;
+}
+
+}  // namespace xforest
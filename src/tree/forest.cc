@@ -0,0 +1,845 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2018 by contributors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//------------------------------------------------------------------------------
+
+/*
+This file is the implementation of Forest class.
+*/
+
+#include "src/tree/forest.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <thread>
+
+#include "src/base/file_util.h"
+#include "src/base/numa.h"
+#include "src/base/random.h"
+#include "src/base/stl-util.h"
+#include "src/base/work_stealing_pool.h"
+#include "src/tree/binning.h"
+#include "src/tree/tree_batch.h"
+
+namespace xforest {
+
+static const uint32 kForestMagic = 0x58464652;  // "XFFR"
+
+Forest::~Forest() {
+  STLDeleteElementsAndClear(&trees_);
+}
+
+// Initialize forest
+void Forest::Initialize(const uint8* X,
+                        const real_t* Y,
+                        const uint8 num_class,
+                        const index_t num_feat,
+                        const index_t data_size,
+                        const HyperParam& hyper_param,
+                        const std::vector<MaxMin>& max_min) {
+  CHECK_NOTNULL(X);
+  CHECK_NOTNULL(Y);
+  CHECK_GT(hyper_param.n_estimators, 0);
+  CHECK_GT(hyper_param.max_features, 0);
+  CHECK_GT(hyper_param.tree_batch_size, 0);
+  if (hyper_param.oob_score && !hyper_param.bootstrap) {
+    LOG(FATAL) << "oob_score is only available if bootstrap is true";
+  }
+  if (hyper_param.n_iter_no_change > 0 && !hyper_param.oob_score) {
+    LOG(FATAL) << "Early stopping is only available if oob_score is true";
+  }
+  // TreeBatch grows the trees by its own sweeps over the dataset
+  if (hyper_param.tree_batch_size > 1 &&
+      (hyper_param.grow_policy != "breadth_first" ||
+       hyper_param.reorder_data ||
+       hyper_param.max_histogram_bytes >= 0 ||
+       hyper_param.prefetch_distance > 0)) {
+    LOG(FATAL) << "tree_batch_size > 1 only supports breadth_first "
+               << "grow_policy, and can not be used with reorder_data, "
+               << "max_histogram_bytes or prefetch_distance";
+  }
+  // New trees must be consistent with the existing ones
+  if (hyper_param.warm_start && !trees_.empty()) {
+    CHECK_EQ(num_class, num_class_);
+    CHECK_EQ(num_feat, num_feat_);
+    CHECK_EQ(hyper_param.max_bin, param_.max_bin);
+    CHECK_EQ(hyper_param.random_state, param_.random_state);
+    CHECK_EQ(hyper_param.bootstrap, param_.bootstrap);
+    CheckMaxMin(max_min);
+  }
+  if (!max_min.empty()) {
+    max_min_ = max_min;
+  }
+  data_.reset();
+  X_ = X;
+  Y_ = Y;
+  num_class_ = num_class;
+  num_feat_ = num_feat;
+  data_size_ = data_size;
+  param_ = hyper_param;
+  // -1 means unlimited
+  if (param_.max_depth == -1) {
+    param_.max_depth = 255;
+  }
+  if (param_.max_leaf_nodes == -1) {
+    param_.max_leaf_nodes = kInt32Max;
+  }
+  SetNJobs(param_.n_jobs);
+  // Calibrate once for all trees, and TreeBatch does not prefetch
+  if (param_.tree_batch_size > 1) {
+    param_.prefetch_distance = 0;
+  } else if (param_.prefetch_distance < 0) {
+    param_.prefetch_distance = 
+      DTree::PrefetchDistance(X_, num_feat_, data_size_);
+  }
+  if (!param_.warm_start) {
+    STLDeleteElementsAndClear(&trees_);
+    n_update_ = 0;
+  }
+}
+
+// Initialize forest on a shared dataset
+void Forest::Initialize(std::shared_ptr<const Dataset> data,
+                        const HyperParam& hyper_param) {
+  CHECK_NOTNULL(data.get());
+  CHECK_LE(data->MaxBin(), hyper_param.max_bin);
+  Initialize(data->X(), 
+             data->Y(), 
+             data->NumClass(), 
+             data->NumFeat(), 
+             data->DataSize(), 
+             hyper_param,
+             data->GetMaxMin());
+  data_ = std::move(data);
+}
+
+// Bin boundaries must be the same as the existing trees
+void Forest::CheckMaxMin(const std::vector<MaxMin>& max_min) const {
+  if (max_min_.empty()) {
+    LOG(FATAL) << "Warm start and Update() need the bin boundaries of "
+               << "the model, which should be set by SetMaxMin() before "
+               << "Save()";
+  }
+  if (max_min.empty()) {
+    LOG(FATAL) << "Warm start and Update() need the bin boundaries of "
+               << "the dataset";
+  }
+  CHECK_EQ(max_min.size(), max_min_.size());
+  for (size_t j = 0; j < max_min.size(); ++j) {
+    if (max_min[j].gap != max_min_[j].gap ||
+        max_min[j].min_feat != max_min_[j].min_feat) {
+      LOG(FATAL) << "Bin boundaries of feature " << j 
+                 << " are different from the model";
+    }
+  }
+}
+
+// Fingerprint of the binned rows and labels
+static uint64 HashData(const uint8* X, 
+                       const real_t* Y,
+                       index_t num_feat, 
+                       index_t data_size) {
+  uint64 len = (uint64)num_feat * data_size;
+  uint64 hash = len;
+  auto mix = [&hash](uint64 val) {
+    hash = (hash ^ val) * 0x9E3779B97F4A7C15ull;
+    hash ^= hash >> 29;
+  };
+  uint64 i = 0;
+  for (; i + sizeof(uint64) <= len; i += sizeof(uint64)) {
+    uint64 val;
+    memcpy(&val, X + i, sizeof(uint64));
+    mix(val);
+  }
+  uint64 tail = 0;
+  memcpy(&tail, X + i, len - i);
+  mix(tail);
+  for (index_t r = 0; r < data_size; ++r) {
+    uint32 y;
+    memcpy(&y, Y + r, sizeof(uint32));
+    mix(y);
+  }
+  return hash;
+}
+
+// Number of threads
+void Forest::SetNJobs(int n_jobs) {
+  n_jobs_ = n_jobs;
+  if (n_jobs_ == -1) {
+    n_jobs_ = std::max(1u, std::thread::hardware_concurrency());
+  }
+  CHECK_GT(n_jobs_, 0);
+  // Current thread also runs tasks while waiting, and
+  // the pool is kept for the following mini-batches
+  if (n_jobs_ == 1) {
+    pool_.reset();
+  } else if (pool_ == nullptr || 
+             pool_->ThreadNumber() != (size_t)n_jobs_ - 1) {
+    pool_.reset(new WorkStealingPool(n_jobs_ - 1));
+  }
+  // The next PredictBatch() creates the pools and replicas
+  replicas_.clear();
+  if (n_jobs_ == 1) {
+    predict_pools_.clear();
+  }
+  predict_ready_ = false;
+}
+
+// Create a tree and sample its rows and features
+DTree* Forest::NewTree(int tree_id) {
+  DTree* tree = CREATE_DTREE("mctree");
+  if (data_ != nullptr) {
+    tree->Initialize(data_, param_);
+  } else {
+    tree->Initialize(X_, Y_, num_class_, num_feat_, data_size_, param_);
+  }
+  // Rows and features of a tree are sampled by the stream of its root
+  // node, so they do not depend on the thread or order of training
+  Philox rng(param_.random_state, tree_id, 0);
+  // Bootstrap samples
+  if (param_.bootstrap) {
+    std::vector<index_t> row_idx;
+    Bootstrap(tree_id, &row_idx);
+    tree->SetRowIdx(row_idx);
+  }
+  // Sample features by partial Fisher-Yates shuffle
+  index_t col_size = std::min((index_t)param_.max_features, num_feat_);
+  if (col_size < num_feat_) {
+    std::vector<index_t> col_idx(num_feat_);
+    std::iota(col_idx.begin(), col_idx.end(), 0);
+    rng.Seek(data_size_);
+    for (index_t i = 0; i < col_size; ++i) {
+      std::swap(col_idx[i], col_idx[i + rng.Uniform(num_feat_ - i)]);
+    }
+    col_idx.resize(col_size);
+    std::sort(col_idx.begin(), col_idx.end());
+    tree->SetColIdx(col_idx);
+  }
+  return tree;
+}
+
+// Bootstrap samples of a tree
+void Forest::Bootstrap(int tree_id, std::vector<index_t>* row_idx) {
+  Philox rng(param_.random_state, tree_id, 0);
+  row_idx->resize(data_size_);
+  for (index_t i = 0; i < data_size_; ++i) {
+    (*row_idx)[i] = rng.UniformAt(i, data_size_);
+  }
+}
+
+// Vote for the rows a tree did not sample
+void Forest::AddOOBVotes(int tree_id, int weight) {
+  std::vector<index_t> row_idx;
+  Bootstrap(tree_id, &row_idx);
+  std::vector<bool> in_bag(data_size_, false);
+  for (index_t idx : row_idx) {
+    in_bag[idx] = true;
+  }
+  DTree* tree = trees_[tree_id];
+  for (index_t i = 0; i < data_size_; ++i) {
+    if (!in_bag[i]) {
+      index_t y = (index_t)tree->Predict(X_ + (uint64)i * num_feat_);
+      oob_votes_[(uint64)i * num_class_ + y].fetch_add(
+        (index_t)weight, std::memory_order_relaxed);
+    }
+  }
+  oob_trees_ += weight;
+}
+
+// Error rate of the out-of-bag votes
+real_t Forest::OOBError() const {
+  CHECK(param_.oob_score);
+  index_t total = 0;
+  index_t wrong = 0;
+  for (index_t i = 0; i < data_size_; ++i) {
+    const std::atomic<index_t>* votes = &oob_votes_[(uint64)i * num_class_];
+    index_t best = 0;
+    index_t sum = 0;
+    for (uint8 c = 0; c < num_class_; ++c) {
+      index_t v = votes[c].load(std::memory_order_relaxed);
+      sum += v;
+      if (v > votes[best].load(std::memory_order_relaxed)) {
+        best = c;
+      }
+    }
+    if (sum > 0) {
+      total++;
+      wrong += best != (index_t)Y_[i];
+    }
+  }
+  return total == 0 ? 1.0 : (real_t)wrong / total;
+}
+
+// Train a group of trees
+void Forest::TrainTrees(int begin, int end, WorkStealingPool* pool) {
+  if (end - begin == 1) {
+    trees_[begin] = NewTree(begin);
+    trees_[begin]->SetPool(pool);
+    trees_[begin]->BuildTree();
+    trees_[begin]->SetPool(nullptr);
+  } else {
+    TreeBatch batch;
+    for (int i = begin; i < end; ++i) {
+      trees_[i] = NewTree(i);
+      batch.AddTree(trees_[i]);
+    }
+    batch.BuildTrees();
+  }
+  if (param_.oob_score) {
+    for (int i = begin; i < end; ++i) {
+      AddOOBVotes(i);
+    }
+  }
+}
+
+// Train trees [begin, end) in parallel
+void Forest::TrainRound(int begin, int end, WorkStealingPool* pool) {
+  int batch_size = param_.tree_batch_size;
+  if (pool == nullptr) {
+    for (int i = begin; i < end; i += batch_size) {
+      TrainTrees(i, std::min(i + batch_size, end), nullptr);
+    }
+    return;
+  }
+  TaskGroup group;
+  for (int i = begin; i < end; i += batch_size) {
+    int batch_end = std::min(i + batch_size, end);
+    pool->Spawn(&group, [this, i, batch_end, pool]() {
+      TrainTrees(i, batch_end, pool);
+    });
+  }
+  pool->Wait(&group);
+}
+
+// Train trees in parallel
+void Forest::Train() {
+  CHECK_NOTNULL(X_);
+  int n_tree = param_.n_estimators;
+  // Existing trees are kept by warm start
+  int n_old = 0;
+  if (param_.warm_start) {
+    n_old = trees_.size();
+    if (n_tree < n_old) {
+      LOG(FATAL) << "n_estimators (" << n_tree << ") must not be less "
+                 << "than the number of existing trees (" << n_old << ")";
+    }
+  } else {
+    STLDeleteElementsAndClear(&trees_);
+  }
+  trees_.resize(n_tree, nullptr);
+  ClearScorer();
+  // The bootstrap samples of the existing trees can only be replayed
+  // on the rows they were trained on
+  uint64 data_hash = HashData(X_, Y_, num_feat_, data_size_);
+  if (n_old == 0 || data_size_ != oob_data_size_ || 
+      data_hash != oob_data_hash_) {
+    oob_begin_ = n_old;
+  }
+  oob_data_size_ = data_size_;
+  oob_data_hash_ = data_hash;
+  WorkStealingPool* pool = pool_.get();
+  if (param_.oob_score) {
+    std::vector<std::atomic<index_t>>(
+      (uint64)data_size_ * num_class_).swap(oob_votes_);
+    oob_trees_ = 0;
+    // Votes of existing trees
+    TaskGroup group;
+    for (int i = oob_begin_; i < n_old; ++i) {
+      if (pool == nullptr) {
+        AddOOBVotes(i);
+      } else {
+        pool->Spawn(&group, [this, i]() { AddOOBVotes(i); });
+      }
+    }
+    if (pool != nullptr) {
+      pool->Wait(&group);
+    }
+  }
+  // Trees are added in rounds of n_iter_no_change trees, and
+  // we stop if a round does not improve the OOB error by tol
+  int window = param_.n_iter_no_change > 0 ? 
+               param_.n_iter_no_change : n_tree;
+  real_t best_error = kFloatMax;
+  if (param_.n_iter_no_change > 0 && n_old > 0) {
+    best_error = OOBError();
+  }
+  for (int begin = n_old; begin < n_tree; begin += window) {
+    int end = std::min(begin + window, n_tree);
+    TrainRound(begin, end, pool);
+    if (param_.n_iter_no_change > 0) {
+      real_t error = OOBError();
+      if (best_error - error < param_.tol) {
+        // Drop the round that does not improve
+        for (int i = begin; i < end; ++i) {
+          AddOOBVotes(i, -1);
+          delete trees_[i];
+        }
+        trees_.resize(begin);
+        break;
+      }
+      best_error = error;
+    }
+  }
+  CollectFeatures();
+}
+
+// Update trees by mini-batch
+void Forest::Update(const Dataset& batch) {
+  CHECK(!trees_.empty());
+  CHECK_LE(batch.MaxBin(), param_.max_bin);
+  CheckMaxMin(batch.GetMaxMin());
+  n_update_++;
+  ClearScorer();
+  auto update = [this, &batch](int tree_id) {
+    MCTree* tree = dynamic_cast<MCTree*>(trees_[tree_id]);
+    CHECK_NOTNULL(tree);
+    index_t len = batch.DataSize();
+    std::vector<index_t> row_idx(len);
+    if (param_.bootstrap) {
+      // Node id 0 is used by the initial samples
+      Philox rng(param_.random_state, tree_id, n_update_);
+      for (index_t i = 0; i < len; ++i) {
+        row_idx[i] = rng.UniformAt(i, len);
+      }
+    } else {
+      std::iota(row_idx.begin(), row_idx.end(), 0);
+    }
+    tree->Update(batch, row_idx, param_);
+  };
+  int n_tree = trees_.size();
+  if (pool_ == nullptr) {
+    for (int i = 0; i < n_tree; ++i) {
+      update(i);
+    }
+  } else {
+    TaskGroup group;
+    for (int i = 0; i < n_tree; ++i) {
+      pool_->Spawn(&group, [&update, i]() { update(i); });
+    }
+    pool_->Wait(&group);
+  }
+  // New leaf nodes may split on other features
+  CollectFeatures();
+}
+
+// Mean of normalized tree importances
+void Forest::FeatureImportances(std::vector<real_t>* importances) const {
+  CHECK_NOTNULL(importances);
+  importances->assign(num_feat_, 0);
+  index_t n_tree = 0;
+  for (const DTree* tree : trees_) {
+    const std::vector<real_t>& tree_importances = tree->FeatureImportances();
+    CHECK_EQ(tree_importances.size(), num_feat_);
+    real_t sum = 0;
+    for (real_t val : tree_importances) {
+      sum += val;
+    }
+    // Tree with single leaf node
+    if (sum <= 0) {
+      continue;
+    }
+    for (index_t j = 0; j < num_feat_; ++j) {
+      (*importances)[j] += tree_importances[j] / sum;
+    }
+    n_tree++;
+  }
+  for (index_t j = 0; n_tree > 0 && j < num_feat_; ++j) {
+    (*importances)[j] /= n_tree;
+  }
+}
+
+// Save forest to file
+void Forest::Save(const std::string& filename) {
+  CHECK(!trees_.empty());
+  FILE* file = OpenFileOrDie(filename.c_str(), "w");
+  index_t n_tree = trees_.size();
+  index_t n_max_min = max_min_.size();
+  WriteDataToDisk(file, (const char*)&kForestMagic, sizeof(uint32));
+  WriteDataToDisk(file, (const char*)&num_class_, sizeof(uint8));
+  WriteDataToDisk(file, (const char*)&num_feat_, sizeof(index_t));
+  WriteDataToDisk(file, (const char*)&param_.max_bin, sizeof(uint8));
+  WriteDataToDisk(file, (const char*)&param_.random_state, sizeof(int));
+  WriteDataToDisk(file, (const char*)&param_.bootstrap, sizeof(bool));
+  WriteDataToDisk(file, (const char*)&oob_data_size_, sizeof(index_t));
+  WriteDataToDisk(file, (const char*)&oob_data_hash_, sizeof(uint64));
+  WriteDataToDisk(file, (const char*)&oob_begin_, sizeof(int));
+  WriteDataToDisk(file, (const char*)&n_update_, sizeof(int));
+  WriteDataToDisk(file, (const char*)&n_max_min, sizeof(index_t));
+  if (n_max_min > 0) {
+    WriteDataToDisk(file, (const char*)max_min_.data(), 
+                    sizeof(MaxMin) * n_max_min);
+  }
+  WriteDataToDisk(file, (const char*)&n_tree, sizeof(index_t));
+  std::string str;
+  for (DTree* tree : trees_) {
+    tree->Serilize(&str);
+    uint64 len = str.size();
+    WriteDataToDisk(file, (const char*)&len, sizeof(uint64));
+    WriteDataToDisk(file, str.data(), len);
+  }
+  Close(file);
+}
+
+// Save compact forest to file
+void Forest::SaveCompact(const std::string& filename) {
+  CHECK(!trees_.empty());
+  if (compact_ != nullptr) {
+    compact_->Save(filename);
+    return;
+  }
+  CompactForest compact;
+  compact.Build(trees_, num_class_, num_feat_);
+  compact.Save(filename);
+}
+
+// Load forest from file
+void Forest::Load(const std::string& filename, 
+                  const std::string& scorer) {
+  FILE* file = OpenFileOrDie(filename.c_str(), "r");
+  uint32 magic = 0;
+  CHECK_EQ(ReadDataFromDisk(file, (char*)&magic, sizeof(uint32)),
+           sizeof(uint32));
+  if (magic != kForestMagic) {
+    LOG(FATAL) << "Not a forest model file: " << filename;
+  }
+  index_t n_tree = 0;
+  index_t n_max_min = 0;
+  CHECK_EQ(ReadDataFromDisk(file, (char*)&num_class_, sizeof(uint8)),
+           sizeof(uint8));
+  CHECK_EQ(ReadDataFromDisk(file, (char*)&num_feat_, sizeof(index_t)),
+           sizeof(index_t));
+  CHECK_EQ(ReadDataFromDisk(file, (char*)&param_.max_bin, sizeof(uint8)),
+           sizeof(uint8));
+  CHECK_EQ(ReadDataFromDisk(file, (char*)&param_.random_state, sizeof(int)),
+           sizeof(int));
+  CHECK_EQ(ReadDataFromDisk(file, (char*)&param_.bootstrap, sizeof(bool)),
+           sizeof(bool));
+  CHECK_EQ(ReadDataFromDisk(file, (char*)&oob_data_size_, sizeof(index_t)),
+           sizeof(index_t));
+  CHECK_EQ(ReadDataFromDisk(file, (char*)&oob_data_hash_, sizeof(uint64)),
+           sizeof(uint64));
+  CHECK_EQ(ReadDataFromDisk(file, (char*)&oob_begin_, sizeof(int)),
+           sizeof(int));
+  CHECK_EQ(ReadDataFromDisk(file, (char*)&n_update_, sizeof(int)),
+           sizeof(int));
+  CHECK_EQ(ReadDataFromDisk(file, (char*)&n_max_min, sizeof(index_t)),
+           sizeof(index_t));
+  max_min_.resize(n_max_min);
+  if (n_max_min > 0) {
+    uint64 len = sizeof(MaxMin) * n_max_min;
+    CHECK_EQ(ReadDataFromDisk(file, (char*)max_min_.data(), len), len);
+  }
+  CHECK_EQ(ReadDataFromDisk(file, (char*)&n_tree, sizeof(index_t)),
+           sizeof(index_t));
+  STLDeleteElementsAndClear(&trees_);
+  ClearScorer();
+  std::string str;
+  for (index_t i = 0; i < n_tree; ++i) {
+    uint64 len = 0;
+    CHECK_EQ(ReadDataFromDisk(file, (char*)&len, sizeof(uint64)), 
+             sizeof(uint64));
+    str.resize(len);
+    CHECK_EQ(ReadDataFromDisk(file, &str[0], len), len);
+    DTree* tree = CREATE_DTREE("mctree");
+    tree->Deserilize(str);
+    trees_.push_back(tree);
+  }
+  Close(file);
+  CollectFeatures();
+  if (!scorer.empty()) {
+    Compile(scorer);
+  }
+}
+
+// Drop the compiled trees
+void Forest::ClearScorer() {
+  flat_trees_.clear();
+  quick_scorer_.reset();
+  compact_.reset();
+  replicas_.clear();
+  predict_ready_ = false;
+}
+
+// Mark the features of split nodes
+static void MarkFeatures(const DTNode* node, std::vector<bool>* used) {
+  if (node->IsLeaf()) {
+    return;
+  }
+  (*used)[node->BestFeatID()] = true;
+  MarkFeatures(node->LeftChild(), used);
+  MarkFeatures(node->RightChild(), used);
+}
+
+// Collect the features used by trees
+void Forest::CollectFeatures() {
+  std::vector<bool> used(num_feat_, false);
+  for (DTree* tree : trees_) {
+    MarkFeatures(tree->Root(), &used);
+  }
+  used_feat_.clear();
+  for (index_t j = 0; j < num_feat_; ++j) {
+    if (used[j]) {
+      used_feat_.push_back(j);
+    }
+  }
+}
+
+// Bin the used features, and predict
+real_t Forest::PredictRaw(const real_t* x) {
+  CHECK_NOTNULL(x);
+  CHECK_EQ(max_min_.size(), num_feat_);
+  // Other features are never read
+  static thread_local std::vector<uint8> row;
+  row.resize(num_feat_);
+  for (index_t j : used_feat_) {
+    row[j] = BinValue(x[j], max_min_[j], param_.max_bin);
+  }
+  return Predict(row.data());
+}
+
+// Build scorer
+void Forest::Compile(const std::string& scorer) {
+  CHECK(!trees_.empty());
+  ClearScorer();
+  if (scorer == "flat") {
+    flat_trees_.resize(trees_.size());
+    for (size_t i = 0; i < trees_.size(); ++i) {
+      flat_trees_[i].Flatten(*trees_[i]);
+    }
+  } else if (scorer == "quickscorer") {
+    if (!QuickScorer::Support(trees_)) {
+      LOG(FATAL) << "quickscorer only supports trees of at most "
+                 << QuickScorer::kMaxLeaf << " leaf nodes";
+    }
+    quick_scorer_.reset(new QuickScorer());
+    quick_scorer_->Build(trees_, num_class_);
+  } else if (scorer == "compact") {
+    compact_.reset(new CompactForest());
+    compact_->Build(trees_, num_class_, num_feat_);
+  } else {
+    LOG(FATAL) << "Unknown scorer: " << scorer;
+  }
+}
+
+// Whether the leading class can not be overtaken by the remaining
+// votes, where ties go to the smaller class as std::max_element()
+static bool Decided(const std::vector<index_t>& votes, 
+                    index_t best, 
+                    index_t remain) {
+  if (votes[best] < remain) {
+    return false;
+  }
+  for (index_t c = 0; c < votes.size(); ++c) {
+    index_t v = votes[c] + remain;
+    if (c != best && (v > votes[best] || (v == votes[best] && c < best))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Majority vote
+real_t Forest::Predict(const uint8* x) {
+  if (quick_scorer_ != nullptr) {
+    return quick_scorer_->Predict(x);
+  }
+  if (compact_ != nullptr) {
+    return compact_->Predict(x);
+  }
+  static thread_local std::vector<index_t> votes;
+  votes.assign(num_class_, 0);
+  bool flat = !flat_trees_.empty();
+  index_t n_tree = trees_.size();
+  index_t best = 0;
+  for (index_t t = 0; t < n_tree; ++t) {
+    index_t y = flat ? (index_t)flat_trees_[t].Predict(x) 
+                     : (index_t)trees_[t]->Predict(x);
+    votes[y]++;
+    if (early_exit_) {
+      if (votes[y] > votes[best] || (votes[y] == votes[best] && y < best)) {
+        best = y;
+      }
+      if (Decided(votes, best, n_tree - t - 1)) {
+        return (real_t)best;
+      }
+    }
+  }
+  return (real_t)std::distance(votes.begin(),
+    std::max_element(votes.begin(), votes.end()));
+}
+
+// Create the pools and replicas by the first caller
+void Forest::InitPredict() {
+  if (predict_ready_.load(std::memory_order_acquire)) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(predict_mutex_);
+  if (predict_ready_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  InitPredictPools();
+  InitReplicas();
+  predict_ready_.store(true, std::memory_order_release);
+}
+
+// Create a pinned pool on each NUMA node
+void Forest::InitPredictPools() {
+  std::vector<NumaNode> nodes;
+  GetNumaNodes(&nodes);
+  size_t num_pool = std::min(nodes.size(), (size_t)n_jobs_);
+  size_t threads = 0;
+  for (auto& pool : predict_pools_) {
+    threads += pool->ThreadNumber();
+  }
+  if (threads == (size_t)n_jobs_ && predict_pools_.size() == num_pool) {
+    return;
+  }
+  predict_pools_.clear();
+  replicas_.clear();
+  for (size_t k = 0; k < num_pool; ++k) {
+    size_t size = n_jobs_ / num_pool + (k < n_jobs_ % num_pool);
+    predict_pools_.emplace_back(new ThreadPool(size));
+    if (!predict_pools_.back()->Pin(nodes[k].cpus)) {
+      LOG(WARNING) << "Failed to pin the threads of NUMA node " 
+                   << nodes[k].id;
+    }
+  }
+}
+
+// Flatten trees by a thread of each NUMA node
+void Forest::InitReplicas() {
+  replicas_.clear();
+  if (predict_pools_.size() <= 1 || flat_trees_.empty()) {
+    return;
+  }
+  replicas_.resize(predict_pools_.size());
+  std::vector<std::future<void>> results;
+  for (size_t k = 0; k < predict_pools_.size(); ++k) {
+    results.push_back(predict_pools_[k]->enqueue([this, k]() {
+      // Nodes are allocated by the first touch of this thread
+      std::vector<FlatTree>& trees = replicas_[k];
+      trees.resize(trees_.size());
+      for (size_t t = 0; t < trees_.size(); ++t) {
+        trees[t].Flatten(*trees_[t]);
+      }
+    }));
+  }
+  for (auto& result : results) {
+    result.get();
+  }
+}
+
+// Majority vote of rows [begin, end)
+void Forest::PredictRange(const std::vector<FlatTree>& flat_trees,
+                          const std::vector<size_t>& block,
+                          const uint8* X, 
+                          index_t begin, 
+                          index_t end, 
+                          real_t* Y) {
+  if (RowScorer()) {
+    for (index_t i = begin; i < end; ++i) {
+      Y[i] = Predict(X + (uint64)i * num_feat_);
+    }
+    return;
+  }
+  std::vector<index_t> votes((size_t)kTileRows * num_class_);
+  std::vector<real_t> leaf_val(kBatchRows);
+  for (index_t tile = begin; tile < end; tile += kTileRows) {
+    index_t tile_end = std::min(end, tile + kTileRows);
+    std::fill(votes.begin(), votes.end(), 0);
+    // A tree block is reused by all row blocks of the tile
+    for (size_t b = 0; b + 1 < block.size(); ++b) {
+      for (index_t row = tile; row < tile_end; row += kBatchRows) {
+        index_t len = std::min(tile_end, row + kBatchRows) - row;
+        const uint8* x = X + (uint64)row * num_feat_;
+        index_t* vote = votes.data() + (size_t)(row - tile) * num_class_;
+        for (size_t t = block[b]; t < block[b + 1]; ++t) {
+          // SIMD traversal of the row block
+          flat_trees[t].PredictRows(x, num_feat_, len, leaf_val.data());
+          for (index_t i = 0; i < len; ++i) {
+            vote[(size_t)i * num_class_ + (index_t)leaf_val[i]]++;
+          }
+        }
+      }
+    }
+    for (index_t i = tile; i < tile_end; ++i) {
+      index_t* vote = votes.data() + (size_t)(i - tile) * num_class_;
+      Y[i] = (real_t)std::distance(vote, 
+        std::max_element(vote, vote + num_class_));
+    }
+  }
+}
+
+// Majority vote of row blocks x tree blocks
+void Forest::PredictBatch(const uint8* X, index_t n, real_t* Y) {
+  CHECK_NOTNULL(X);
+  CHECK_NOTNULL(Y);
+  CHECK(!trees_.empty());
+  index_t num_block = (n + kBatchRows - 1) / kBatchRows;
+  size_t num_task = std::min((size_t)n_jobs_, (size_t)num_block);
+  // The caller scores the rows of one task
+  if (num_task > 1) {
+    InitPredict();
+  }
+  std::vector<FlatTree> local_trees;
+  const std::vector<FlatTree>* flat_trees = &flat_trees_;
+  if (!replicas_.empty() && num_task > 1) {
+    flat_trees = &replicas_[0];
+  } else if (flat_trees_.empty() && !RowScorer()) {
+    local_trees.resize(trees_.size());
+    for (size_t t = 0; t < trees_.size(); ++t) {
+      local_trees[t].Flatten(*trees_[t]);
+    }
+    flat_trees = &local_trees;
+  }
+  // Tree blocks [block[b], block[b+1])
+  std::vector<size_t> block(1, 0);
+  size_t bytes = 0;
+  for (size_t t = 0; t < flat_trees->size(); ++t) {
+    size_t tree_bytes = (*flat_trees)[t].NumNode() * sizeof(FlatNode);
+    if (bytes + tree_bytes > kTreeBlockBytes && t > block.back()) {
+      block.push_back(t);
+      bytes = 0;
+    }
+    bytes += tree_bytes;
+  }
+  block.push_back(flat_trees->size());
+  if (num_task <= 1) {
+    PredictRange(*flat_trees, block, X, 0, n, Y);
+    return;
+  }
+  // Tasks of contiguous row blocks, which are dealt to the NUMA 
+  // nodes in turn, and read the trees of their node
+  std::vector<std::future<void>> results;
+  for (size_t task = 0; task < num_task; ++task) {
+    size_t k = task % predict_pools_.size();
+    const std::vector<FlatTree>& trees = 
+      replicas_.empty() ? *flat_trees : replicas_[k];
+    index_t begin = getStart(num_block, num_task, task) * kBatchRows;
+    index_t end = std::min((uint64)n, 
+      (uint64)getEnd(num_block, num_task, task) * kBatchRows);
+    results.push_back(predict_pools_[k]->enqueue(
+      [this, &trees, &block, X, begin, end, Y]() {
+        PredictRange(trees, block, X, begin, end, Y);
+      }));
+  }
+  for (auto& result : results) {
+    result.get();
+  }
+}
+
+}  // namespace xforest
@@ -0,0 +1,482 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2018 by contributors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//------------------------------------------------------------------------------
+
+/*!
+*  Copyright (c) 2018 by Contributors
+* \file forest.h
+* \brief This file defines the Forest class.
+*/
+#ifndef XFOREST_TREE_FOREST_H_
+#define XFOREST_TREE_FOREST_H_
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "src/base/common.h"
+#include "src/base/thread_pool.h"
+#include "src/solver/hyper_parameter.h"
+#include "src/tree/compact_forest.h"
+#include "src/tree/dtree.h"
+#include "src/tree/flat_tree.h"
+#include "src/tree/quick_scorer.h"
+
+namespace xforest {
+
+/*!
+* \brief Forest is a random forest of classification trees. The trees
+* are trained in parallel by a WorkStealingPool with n_jobs threads, and
+* each tree task splits its large nodes into row chunks that idle threads
+* can steal, so that the last few trees still use all of the threads.
+* All of the trees share the same read-only binned dataset, and each of
+* them has its own sampled rows (bootstrap) and features. Basic usage:
+*
+*   Forest forest;
+*   forest.Initialize(X, Y, num_class, num_feat, data_size, hyper_param);
+*   forest.Train();
+*   real_t y = forest.Predict(x);
+*
+* Note that the dataset must be alive until Train() returns, unless
+* the forest is initialized by a shared Dataset.
+*
+* A trained forest can be saved together with its bin boundaries, and
+* then loaded to predict, or to add more trees (warm_start = true) to
+* it on a dataset binned by the same boundaries:
+*
+*   forest.SetMaxMin(max_min);
+*   forest.Save(filename);
+*   ...
+*   Forest forest;
+*   forest.Load(filename);
+*   hyper_param.warm_start = true;
+*   hyper_param.n_estimators += 100;
+*   forest.Initialize(X, Y, num_class, num_feat, data_size, 
+*                     hyper_param, max_min);
+*   forest.Train();  // Only train the new trees
+*
+* The OOB votes of the existing trees are only replayed if the dataset
+* is the same as the last one they were trained on (by its size and a
+* hash of the rows and labels), and otherwise only the new trees vote.
+*
+* For inference, Compile() copies the trees to a scorer, which is used
+* by Predict() until the trees change. The scorer is "flat" (FlatTree),
+* "quickscorer" (QuickScorer) for trees of at most 64 leaf nodes, or
+* "compact" (CompactForest) for the smallest model:
+*
+*   forest.Load(filename, "quickscorer");
+*   real_t y = forest.Predict(x);
+*
+* The compact model can also be saved by SaveCompact(), and then loaded 
+* and scored by CompactForest alone.
+*/
+class Forest {
+ public:
+  /*!
+  * \brief Constructor and Destructor
+  */
+  Forest() { }
+  ~Forest();
+
+  /*!
+  * \brief Initialize forest.
+  * \param X pointer of dataset
+  * \param Y pointer of label
+  * \param num_class number of classification
+  * \param num_feat number of feature
+  * \param data_size size of dataset
+  * \param hyper_param hyper-parameter used by forest
+  * \param max_min bin boundaries of the dataset, which are saved with
+  * the model. Warm start on existing trees requires them, and they
+  * must be the same as the bin boundaries of the model.
+  */
+  void Initialize(const uint8* X,
+                  const real_t* Y,
+                  const uint8 num_class,
+                  const index_t num_feat,
+                  const index_t data_size,
+                  const HyperParam& hyper_param,
+                  const std::vector<MaxMin>& max_min = 
+                    std::vector<MaxMin>());
+
+  /*!
+  * \brief Initialize forest on a shared dataset, which is kept alive
+  * by the forest and its trees. The bin boundaries of the dataset are
+  * saved with the model.
+  * \param data shared dataset
+  * \param hyper_param hyper-parameter used by forest
+  */
+  void Initialize(std::shared_ptr<const Dataset> data,
+                  const HyperParam& hyper_param);
+
+  /*!
+  * \brief Save forest and bin boundaries to file.
+  * \param filename name of model file
+  */
+  void Save(const std::string& filename);
+
+  /*!
+  * \brief Save the trees as a CompactForest, which can only be used
+  * to predict (see CompactForest::Load()).
+  * \param filename name of compact model file
+  */
+  void SaveCompact(const std::string& filename);
+
+  /*!
+  * \brief Load forest and bin boundaries from file.
+  * \param filename name of model file
+  * \param scorer scorer to compile (empty for none)
+  */
+  void Load(const std::string& filename, 
+            const std::string& scorer = "");
+
+  /*!
+  * \brief Set bin boundaries used to bin the dataset,
+  * which are saved with the model.
+  */
+  inline void SetMaxMin(const std::vector<MaxMin>& max_min) {
+    max_min_ = max_min;
+  }
+
+  /*!
+  * \brief Bin boundaries of the model.
+  */
+  inline const std::vector<MaxMin>& GetMaxMin() const {
+    return max_min_;
+  }
+
+  /*!
+  * \brief Train n_estimators trees in parallel. If n_iter_no_change
+  * > 0, trees are added in rounds of n_iter_no_change trees, and the
+  * training stops early when a round does not improve the OOB error
+  * by at least tol. The result does not depend on n_jobs.
+  */
+  void Train();
+
+  /*!
+  * \brief Update trees by a mini-batch of new rows, which splits the
+  * leaf nodes that collect enough evidence (see MCTree::Update). Each
+  * tree samples its rows of the batch by bootstrap, and the trees are
+  * updated in parallel. The OOB votes are not updated. Initialize()
+  * must be called before (with warm_start = true for a loaded model).
+  * The bootstrap of each update depends on the number of updates so
+  * far, which is saved with the model.
+  * \param batch new rows binned by the bin boundaries of the model
+  * (checked against Dataset::GetMaxMin())
+  */
+  void Update(const Dataset& batch);
+
+  /*!
+  * \brief Set the number of threads of Train(), Update() and
+  * PredictBatch(), e.g., for a loaded model. -1 means using all
+  * processors. The pool of Train() and Update() is created here, and
+  * the pools of PredictBatch() by its next parallel call. The pools
+  * are kept until the number (or the NUMA topology) changes.
+  */
+  void SetNJobs(int n_jobs);
+
+  /*!
+  * \brief Build the scorer used by Predict(). It is dropped by 
+  * Train(), Update() and Load().
+  * \param scorer "flat", "quickscorer" or "compact"
+  */
+  void Compile(const std::string& scorer = "flat");
+
+  /*!
+  * \brief Stop the majority vote of Predict() as soon as the leading
+  * class can not be overtaken by the remaining trees, which gives the
+  * same label with fewer trees on easy rows. It is ignored by the
+  * quickscorer, which scores all of the trees at once, and by the
+  * compact scorer.
+  */
+  inline void SetEarlyExit(bool early_exit) {
+    early_exit_ = early_exit;
+  }
+
+  /*!
+  * \brief Given data x, predict label y by majority vote.
+  * \param x pointer of data example
+  * \return predicted label y
+  */
+  real_t Predict(const uint8* x);
+
+  /*!
+  * \brief Given raw data x, predict label y by majority vote. Only the
+  * features used by the trees are binned, by the bin boundaries saved
+  * with the model (see SetMaxMin()), which are the same as the ones
+  * used to bin the training data. The used features are collected by
+  * Train(), Update() and Load(), so PredictRaw() only reads the forest
+  * and can be called by many threads.
+  * \param x pointer of raw data example (num_feat values)
+  * \return predicted label y
+  */
+  real_t PredictRaw(const real_t* x);
+
+  /*!
+  * \brief Predict labels of many rows by majority vote. The rows are
+  * scored in tiles of kTileRows rows, and the trees in blocks of about
+  * kTreeBlockBytes flat nodes: a block of trees stays in cache while
+  * the rows of a tile stream through it in blocks of kBatchRows rows,
+  * and the votes of the tile are kept until all tree blocks are done.
+  * Each tree walks the rows of a block by FlatTree::PredictRows(),
+  * which uses the SIMD kernel of current CPU. The trees are flattened
+  * on-the-fly if the forest is not compiled.
+  *
+  * If n_jobs > 1, contiguous row blocks are scored in parallel by a
+  * ThreadPool on each NUMA node, whose threads are pinned to the cores
+  * of the node. On a machine of more than one node, each node keeps
+  * its own copy of the flat trees compiled by Compile("flat"), which
+  * is allocated by a thread of the node, so that the threads read the
+  * nodes of their local memory. The pools and replicas are created by
+  * the first parallel PredictBatch() after Compile() or SetNJobs(),
+  * so a forest that is only trained has no such threads. After that
+  * PredictBatch() only reads the forest and can be called by many
+  * threads, but not together with the methods that change it.
+  * \param X pointer of data examples (n * num_feat)
+  * \param n number of rows
+  * \param Y preallocated labels of n rows
+  */
+  void PredictBatch(const uint8* X, index_t n, real_t* Y);
+
+  /*! \brief Number of rows of a block in PredictBatch() */
+  static const index_t kBatchRows = 256;
+  /*! \brief Number of rows sharing a tree block in PredictBatch() */
+  static const index_t kTileRows = 16 * kBatchRows;
+  /*! \brief Node bytes of a tree block in PredictBatch() */
+  static const size_t kTreeBlockBytes = 256 * 1024;
+
+  /*!
+  * \brief Impurity-based feature importances, which are the mean of
+  * the normalized importances of trees, and sum to 1. The importances
+  * are accumulated by each tree in training, and merged here.
+  * \param importances importance of each feature
+  */
+  void FeatureImportances(std::vector<real_t>* importances) const;
+
+  /*!
+  * \brief Number of trees in forest.
+  */
+  inline size_t NumTree() const {
+    return trees_.size();
+  }
+
+  /*!
+  * \brief The i-th tree in forest.
+  */
+  inline const DTree* Tree(size_t i) const {
+    CHECK_LT(i, trees_.size());
+    return trees_[i];
+  }
+
+  /*!
+  * \brief Number of NUMA nodes that keep a copy of the flat trees
+  * (0 for none, or before the first parallel PredictBatch()).
+  */
+  inline size_t NumReplica() const {
+    return replicas_.size();
+  }
+
+  /*!
+  * \brief Number of classification.
+  */
+  inline uint8 NumClass() const {
+    return num_class_;
+  }
+
+  /*!
+  * \brief Number of feature.
+  */
+  inline index_t NumFeat() const {
+    return num_feat_;
+  }
+
+  /*!
+  * \brief Out-of-bag error of the trees finished so far, which is the
+  * error rate of the majority vote over the trees that did not sample
+  * the row, among the rows that have such trees. It can be called
+  * during training, and requires oob_score = true.
+  * \return 1.0 if no row has out-of-bag votes
+  */
+  real_t OOBError() const;
+
+  /*!
+  * \brief Number of trees whose out-of-bag votes are accumulated.
+  */
+  inline int NumOOBTree() const {
+    return oob_trees_;
+  }
+
+  /*!
+  * \brief Number of updates by mini-batches, which is kept by Save()
+  * and Load().
+  */
+  inline int NumUpdate() const {
+    return n_update_;
+  }
+
+ protected:
+  /*! \brief Hyper-parameters used by trees */
+  HyperParam param_;
+  /*! \brief Shared dataset (nullptr for raw pointers) */
+  std::shared_ptr<const Dataset> data_;
+  /*! \brief Pointer of dataset */
+  const uint8* X_ = nullptr;
+  /*! \brief Pointer of label */
+  const real_t* Y_ = nullptr;
+  /*! \brief Number of classification */
+  uint8 num_class_ = 0;
+  /*! \brief Number of feature */
+  index_t num_feat_ = 0;
+  /*! \brief Size of dataset */
+  index_t data_size_ = 0;
+  /*! \brief Number of threads */
+  int n_jobs_ = 1;
+  /*! \brief Pool of Train() and Update() (nullptr for one thread) */
+  std::unique_ptr<WorkStealingPool> pool_;
+  /*! \brief Trees in forest */
+  std::vector<DTree*> trees_;
+  /*! \brief Flat layout of trees (empty if not compiled) */
+  std::vector<FlatTree> flat_trees_;
+  /*! \brief QuickScorer of trees (nullptr if not compiled) */
+  std::unique_ptr<QuickScorer> quick_scorer_;
+  /*! \brief CompactForest of trees (nullptr if not compiled) */
+  std::unique_ptr<CompactForest> compact_;
+  /*! \brief Stop the vote of Predict() once it is decided */
+  bool early_exit_ = false;
+  /*! \brief Features used by trees */
+  std::vector<index_t> used_feat_;
+  /*! \brief Prediction pool of each NUMA node */
+  std::vector<std::unique_ptr<ThreadPool>> predict_pools_;
+  /*! \brief Flat trees of each NUMA node (empty for one node) */
+  std::vector<std::vector<FlatTree>> replicas_;
+  /*! \brief The pools and replicas are ready for PredictBatch() */
+  std::atomic_bool predict_ready_ { false };
+  /*! \brief Guard of the first PredictBatch() that creates them */
+  std::mutex predict_mutex_;
+  /*! \brief Number of updates by mini-batches (saved by Save()) */
+  int n_update_ = 0;
+  /*! \brief Bin boundaries of each feature */
+  std::vector<MaxMin> max_min_;
+  /*! \brief Size and hash of the dataset of the last Train() */
+  index_t oob_data_size_ = 0;
+  uint64 oob_data_hash_ = 0;
+  /*! \brief Trees [oob_begin_, n) are trained on that dataset */
+  int oob_begin_ = 0;
+  /*! \brief Out-of-bag votes of each row and class */
+  std::vector<std::atomic<index_t>> oob_votes_;
+  /*! \brief Number of trees that voted */
+  std::atomic_int oob_trees_ { 0 };
+
+  /*!
+  * \brief Fail if the bin boundaries of the dataset are missing or
+  * different from the model.
+  */
+  void CheckMaxMin(const std::vector<MaxMin>& max_min) const;
+
+  /*!
+  * \brief Create a tree and sample its rows and features.
+  * \param tree_id id of the tree
+  * \return new tree
+  */
+  DTree* NewTree(int tree_id);
+
+  /*!
+  * \brief Bootstrap samples of a tree.
+  * \param tree_id id of the tree
+  * \param row_idx sampled index of dataset
+  */
+  void Bootstrap(int tree_id, std::vector<index_t>* row_idx);
+
+  /*!
+  * \brief Add the votes of a finished tree to the rows it
+  * did not sample, which is lock-free.
+  * \param tree_id id of the tree
+  * \param weight 1 to add the votes, and -1 to take them back
+  */
+  void AddOOBVotes(int tree_id, int weight = 1);
+
+  /*!
+  * \brief Train a group of trees [begin, end).
+  * \param pool pool for the node tasks (nullptr for none)
+  */
+  void TrainTrees(int begin, int end, WorkStealingPool* pool);
+
+  /*!
+  * \brief Drop the compiled trees, which are rebuilt by Compile().
+  */
+  void ClearScorer();
+
+  /*!
+  * \brief Collect the features of split nodes into used_feat_, which
+  * is called whenever the trees change, i.e., by Train(), Update()
+  * and Load().
+  */
+  void CollectFeatures();
+
+  /*!
+  * \brief Whether the compiled scorer predicts row by row.
+  */
+  inline bool RowScorer() const {
+    return quick_scorer_ != nullptr || compact_ != nullptr;
+  }
+
+  /*!
+  * \brief Create the prediction pools and replicas once, by the
+  * first PredictBatch() that needs more than one thread since the
+  * forest or n_jobs changed. Later calls only read them.
+  */
+  void InitPredict();
+
+  /*!
+  * \brief Create the prediction pools of n_jobs (> 1) threads in
+  * total, which are dealt to the NUMA nodes, unless they already
+  * exist.
+  */
+  void InitPredictPools();
+
+  /*!
+  * \brief Flatten the trees of each NUMA node by a thread of its
+  * pool if the forest is compiled to flat trees on more than one
+  * node, and drop the replicas otherwise.
+  */
+  void InitReplicas();
+
+  /*!
+  * \brief Majority vote of rows [begin, end) by blocks of trees.
+  * \param flat_trees trees to vote (unused by RowScorer())
+  * \param block tree blocks [block[b], block[b+1])
+  */
+  void PredictRange(const std::vector<FlatTree>& flat_trees,
+                    const std::vector<size_t>& block,
+                    const uint8* X, 
+                    index_t begin, 
+                    index_t end, 
+                    real_t* Y);
+
+  /*!
+  * \brief Train trees [begin, end) in batches of tree_batch_size.
+  * \param pool pool for the tree tasks (nullptr for serial)
+  */
+  void TrainRound(int begin, int end, WorkStealingPool* pool);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(Forest);
+};
+
+}  // namespace xforest
+
+#endif  // XFOREST_TREE_FOREST_H_
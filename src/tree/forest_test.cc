@@ -0,0 +1,613 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2018 by contributors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//------------------------------------------------------------------------------
+
+/*!
+*  Copyright (c) 2018 by Contributors
+* \file forest_test.cc
+* \brief This file tests forest.h file.
+*/
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <vector>
+#include <random>
+#include <thread>
+
+#include "src/base/common.h"
+#include "src/base/file_util.h"
+#include "src/base/numa.h"
+#include "src/tree/binning.h"
+#include "src/tree/forest.h"
+
+namespace xforest {
+
+static const index_t kNumFeat = 10;
+static const index_t kDataSize = 3000;
+static const uint8 kMaxBin = 63;
+
+// Generate a noisy dataset with 3 classes
+void GenData(std::vector<uint8>& X, std::vector<real_t>& Y) {
+  std::mt19937 rng(1231);
+  X.resize(kNumFeat * kDataSize);
+  Y.resize(kDataSize);
+  for (index_t i = 0; i < kDataSize; ++i) {
+    uint8* row = X.data() + i * kNumFeat;
+    for (index_t j = 0; j < kNumFeat; ++j) {
+      row[j] = rng() % (kMaxBin + 1);
+    }
+    Y[i] = (row[0] + row[1] + row[2] + rng() % 32) * 3 / (kMaxBin * 3 + 32);
+  }
+}
+
+HyperParam GetParam() {
+  HyperParam param;
+  param.max_bin = kMaxBin;
+  param.n_estimators = 20;
+  param.max_features = 5;
+  param.max_depth = 12;
+  param.n_jobs = 1;
+  return param;
+}
+
+void ExpectSame(Forest& a, Forest& b, const std::vector<uint8>& X) {
+  for (index_t i = 0; i < kDataSize; ++i) {
+    const uint8* x = X.data() + i * kNumFeat;
+    EXPECT_EQ(a.Predict(x), b.Predict(x));
+  }
+}
+
+TEST(ForestTest, Train) {
+  std::vector<uint8> X;
+  std::vector<real_t> Y;
+  GenData(X, Y);
+  Forest forest;
+  forest.Initialize(X.data(), Y.data(), 3, kNumFeat, kDataSize, GetParam());
+  forest.Train();
+  EXPECT_EQ(forest.NumTree(), 20);
+  index_t correct = 0;
+  for (index_t i = 0; i < kDataSize; ++i) {
+    if (forest.Predict(X.data() + i * kNumFeat) == Y[i]) {
+      correct++;
+    }
+  }
+  EXPECT_GT(correct, kDataSize * 0.9);
+}
+
+TEST(ForestTest, Compile) {
+  std::vector<uint8> X;
+  std::vector<real_t> Y;
+  GenData(X, Y);
+  Forest forest;
+  forest.Initialize(X.data(), Y.data(), 3, kNumFeat, kDataSize, GetParam());
+  forest.Train();
+  std::vector<real_t> pred(kDataSize);
+  for (index_t i = 0; i < kDataSize; ++i) {
+    pred[i] = forest.Predict(X.data() + i * kNumFeat);
+  }
+  forest.Compile();
+  for (index_t i = 0; i < kDataSize; ++i) {
+    EXPECT_EQ(forest.Predict(X.data() + i * kNumFeat), pred[i]);
+  }
+}
+
+TEST(ForestTest, Early_exit) {
+  std::vector<uint8> X;
+  std::vector<real_t> Y;
+  GenData(X, Y);
+  HyperParam param = GetParam();
+  Forest forest;
+  forest.Initialize(X.data(), Y.data(), 3, kNumFeat, kDataSize, param);
+  forest.Train();
+  std::vector<real_t> Y_full(kDataSize);
+  for (index_t i = 0; i < kDataSize; ++i) {
+    Y_full[i] = forest.Predict(X.data() + i * kNumFeat);
+  }
+  forest.SetEarlyExit(true);
+  for (index_t i = 0; i < kDataSize; ++i) {
+    EXPECT_EQ(forest.Predict(X.data() + i * kNumFeat), Y_full[i]);
+  }
+  forest.Compile("flat");
+  for (index_t i = 0; i < kDataSize; ++i) {
+    EXPECT_EQ(forest.Predict(X.data() + i * kNumFeat), Y_full[i]);
+  }
+}
+
+TEST(ForestTest, Predict_batch) {
+  std::vector<uint8> X;
+  std::vector<real_t> Y;
+  GenData(X, Y);
+  Forest forest;
+  forest.Initialize(X.data(), Y.data(), 3, kNumFeat, kDataSize, GetParam());
+  forest.Train();
+  // The last block is not full
+  std::vector<real_t> pred(kDataSize, -1);
+  forest.PredictBatch(X.data(), kDataSize, pred.data());
+  for (index_t i = 0; i < kDataSize; ++i) {
+    EXPECT_EQ(forest.Predict(X.data() + i * kNumFeat), pred[i]);
+  }
+  std::vector<real_t> compiled_pred(kDataSize, -1);
+  forest.Compile();
+  forest.PredictBatch(X.data(), kDataSize, compiled_pred.data());
+  EXPECT_EQ(pred, compiled_pred);
+}
+
+TEST(ForestTest, Predict_tiles) {
+  std::vector<uint8> X;
+  std::vector<real_t> Y;
+  GenData(X, Y);
+  HyperParam param = GetParam();
+  param.n_estimators = 80;
+  Forest forest;
+  forest.Initialize(X.data(), Y.data(), 3, kNumFeat, kDataSize, param);
+  forest.Train();
+  // More than one tree block
+  size_t bytes = 0;
+  for (size_t t = 0; t < forest.NumTree(); ++t) {
+    FlatTree flat_tree;
+    flat_tree.Flatten(*forest.Tree(t));
+    bytes += flat_tree.NumNode() * sizeof(FlatNode);
+  }
+  EXPECT_GT(bytes, (size_t)Forest::kTreeBlockBytes);
+  // More than one tile, and the last one is not full
+  index_t n = 2 * Forest::kTileRows + 100;
+  std::vector<uint8> rows((uint64)n * kNumFeat);
+  for (index_t i = 0; i < n; ++i) {
+    std::copy_n(X.data() + (i % kDataSize) * kNumFeat, kNumFeat,
+                rows.data() + (uint64)i * kNumFeat);
+  }
+  std::vector<real_t> pred(n, -1);
+  forest.PredictBatch(rows.data(), n, pred.data());
+  for (index_t i = 0; i < n; ++i) {
+    EXPECT_EQ(forest.Predict(rows.data() + (uint64)i * kNumFeat), pred[i]);
+  }
+}
+
+TEST(ForestTest, Parallel_predict) {
+  std::vector<uint8> X;
+  std::vector<real_t> Y;
+  GenData(X, Y);
+  Forest forest;
+  forest.Initialize(X.data(), Y.data(), 3, kNumFeat, kDataSize, GetParam());
+  forest.Train();
+  std::vector<real_t> pred(kDataSize, -1);
+  forest.PredictBatch(X.data(), kDataSize, pred.data());
+  // More threads than row blocks, and fewer
+  for (int n_jobs : {4, 32}) {
+    forest.SetNJobs(n_jobs);
+    std::vector<real_t> parallel_pred(kDataSize, -1);
+    forest.PredictBatch(X.data(), kDataSize, parallel_pred.data());
+    EXPECT_EQ(pred, parallel_pred);
+    forest.Compile();
+    forest.PredictBatch(X.data(), kDataSize, parallel_pred.data());
+    EXPECT_EQ(pred, parallel_pred);
+  }
+  // Small batch is scored by the caller
+  std::vector<real_t> small_pred(10, -1);
+  forest.PredictBatch(X.data(), 10, small_pred.data());
+  EXPECT_TRUE(std::equal(small_pred.begin(), small_pred.end(), pred.begin()));
+}
+
+TEST(ForestTest, Numa_replicas) {
+  std::vector<uint8> X;
+  std::vector<real_t> Y;
+  GenData(X, Y);
+  Forest forest;
+  forest.Initialize(X.data(), Y.data(), 3, kNumFeat, kDataSize, GetParam());
+  forest.Train();
+  std::vector<real_t> pred(kDataSize, -1);
+  forest.PredictBatch(X.data(), kDataSize, pred.data());
+  // Two nodes of the CPUs of this process
+  std::vector<int> cpus;
+  GetAffinityCpus(&cpus);
+  std::vector<NumaNode> nodes(2);
+  nodes[1].id = 1;
+  for (size_t i = 0; i < std::max(cpus.size(), (size_t)2); ++i) {
+    nodes[i % 2].cpus.push_back(cpus[i % cpus.size()]);
+  }
+  SetNumaNodes(nodes);
+  forest.SetNJobs(4);
+  forest.Compile();
+  EXPECT_EQ(forest.NumReplica(), 0);
+  // Concurrent first callers create the pools and replicas once
+  std::vector<std::vector<real_t>> thread_pred(4);
+  std::vector<std::thread> threads;
+  for (auto& tp : thread_pred) {
+    tp.assign(kDataSize, -1);
+    threads.emplace_back([&forest, &X, &tp]() {
+      forest.PredictBatch(X.data(), kDataSize, tp.data());
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (auto& tp : thread_pred) {
+    EXPECT_EQ(pred, tp);
+  }
+  EXPECT_EQ(forest.NumReplica(), 2);
+  std::vector<real_t> parallel_pred(kDataSize, -1);
+  forest.PredictBatch(X.data(), kDataSize, parallel_pred.data());
+  EXPECT_EQ(pred, parallel_pred);
+  // Compile() drops the replicas until the next call
+  forest.Compile();
+  EXPECT_EQ(forest.NumReplica(), 0);
+  forest.PredictBatch(X.data(), kDataSize, parallel_pred.data());
+  EXPECT_EQ(forest.NumReplica(), 2);
+  EXPECT_EQ(pred, parallel_pred);
+  // One thread needs no replicas
+  forest.SetNJobs(1);
+  EXPECT_EQ(forest.NumReplica(), 0);
+  SetNumaNodes(std::vector<NumaNode>());
+}
+
+TEST(ForestTest, Quick_scorer) {
+  std::vector<uint8> X;
+  std::vector<real_t> Y;
+  GenData(X, Y);
+  HyperParam param = GetParam();
+  param.max_leaf_nodes = 64;
+  Forest forest;
+  forest.Initialize(X.data(), Y.data(), 3, kNumFeat, kDataSize, param);
+  forest.Train();
+  forest.Save("/tmp/xforest_test.model");
+  Forest quick_forest;
+  quick_forest.Load("/tmp/xforest_test.model", "quickscorer");
+  ExpectSame(forest, quick_forest, X);
+  RemoveFile("/tmp/xforest_test.model");
+}
+
+TEST(ForestTest, Compact) {
+  std::vector<uint8> X;
+  std::vector<real_t> Y;
+  GenData(X, Y);
+  Forest forest;
+  forest.Initialize(X.data(), Y.data(), 3, kNumFeat, kDataSize, GetParam());
+  forest.Train();
+  forest.Save("/tmp/xforest_test.model");
+  Forest compact_forest;
+  compact_forest.Load("/tmp/xforest_test.model", "compact");
+  ExpectSame(forest, compact_forest, X);
+  std::vector<real_t> pred(kDataSize, -1);
+  compact_forest.SetNJobs(4);
+  compact_forest.PredictBatch(X.data(), kDataSize, pred.data());
+  // Scored by CompactForest alone
+  forest.SaveCompact("/tmp/xforest_test.model");
+  CompactForest compact;
+  compact.Load("/tmp/xforest_test.model");
+  for (index_t i = 0; i < kDataSize; ++i) {
+    const uint8* x = X.data() + i * kNumFeat;
+    EXPECT_EQ(compact.Predict(x), forest.Predict(x));
+    EXPECT_EQ(pred[i], forest.Predict(x));
+  }
+  RemoveFile("/tmp/xforest_test.model");
+}
+
+TEST(ForestTest, Parallel) {
+  std::vector<uint8> X;
+  std::vector<real_t> Y;
+  GenData(X, Y);
+  HyperParam param = GetParam();
+  Forest forest;
+  forest.Initialize(X.data(), Y.data(), 3, kNumFeat, kDataSize, param);
+  forest.Train();
+  param.n_jobs = 4;
+  Forest parallel_forest;
+  parallel_forest.Initialize(X.data(), Y.data(), 3, kNumFeat, kDataSize, param);
+  parallel_forest.Train();
+  ExpectSame(forest, parallel_forest, X);
+  param.tree_batch_size = 6;
+  Forest batch_forest;
+  batch_forest.Initialize(X.data(), Y.data(), 3, kNumFeat, kDataSize, param);
+  batch_forest.Train();
+  ExpectSame(forest, batch_forest, X);
+  // Options of DTree::BuildTree() are not supported by TreeBatch
+  HyperParam depth_param = param;
+  depth_param.grow_policy = "depth_first";
+  EXPECT_DEATH(batch_forest.Initialize(X.data(), Y.data(), 3, kNumFeat, 
+                                       kDataSize, depth_param), 
+               "tree_batch_size");
+  HyperParam histo_param = param;
+  histo_param.max_histogram_bytes = 1 << 20;
+  EXPECT_DEATH(batch_forest.Initialize(X.data(), Y.data(), 3, kNumFeat, 
+                                       kDataSize, histo_param), 
+               "tree_batch_size");
+}
+
+TEST(ForestTest, Reproducible) {
+  std::vector<uint8> X;
+  std::vector<real_t> Y;
+  GenData(X, Y);
+  HyperParam param = GetParam();
+  param.max_features = 3;
+  Forest forest;
+  forest.Initialize(X.data(), Y.data(), 3, kNumFeat, kDataSize, param);
+  forest.Train();
+  // Samples of each tree do not depend on the number of threads
+  for (int n_jobs : { 2, 7 }) {
+    param.n_jobs = n_jobs;
+    Forest parallel_forest;
+    parallel_forest.Initialize(X.data(), Y.data(), 3, 
+                               kNumFeat, kDataSize, param);
+    parallel_forest.Train();
+    ExpectSame(forest, parallel_forest, X);
+  }
+}
+
+TEST(ForestTest, OOB_error) {
+  std::vector<uint8> X;
+  std::vector<real_t> Y;
+  GenData(X, Y);
+  HyperParam param = GetParam();
+  param.oob_score = true;
+  Forest forest;
+  forest.Initialize(X.data(), Y.data(), 3, kNumFeat, kDataSize, param);
+  forest.Train();
+  EXPECT_EQ(forest.NumOOBTree(), 20);
+  real_t error = forest.OOBError();
+  EXPECT_GT(error, 0.0);
+  EXPECT_LT(error, 0.4);
+  // Votes are added in any order
+  param.n_jobs = 4;
+  param.tree_batch_size = 3;
+  Forest parallel_forest;
+  parallel_forest.Initialize(X.data(), Y.data(), 3, 
+                             kNumFeat, kDataSize, param);
+  parallel_forest.Train();
+  EXPECT_EQ(parallel_forest.OOBError(), error);
+}
+
+TEST(ForestTest, Early_stopping) {
+  std::vector<uint8> X;
+  std::vector<real_t> Y;
+  GenData(X, Y);
+  HyperParam param = GetParam();
+  param.n_estimators = 500;
+  param.oob_score = true;
+  param.n_iter_no_change = 10;
+  param.tol = 0.005;
+  Forest forest;
+  forest.Initialize(X.data(), Y.data(), 3, kNumFeat, kDataSize, param);
+  forest.Train();
+  EXPECT_LT(forest.NumTree(), 500);
+  EXPECT_EQ(forest.NumTree() % 10, 0);
+  EXPECT_EQ(forest.NumOOBTree(), forest.NumTree());
+  // The round that does not improve is dropped with its votes
+  HyperParam full_param = param;
+  full_param.n_estimators = forest.NumTree();
+  full_param.n_iter_no_change = -1;
+  Forest full_forest;
+  full_forest.Initialize(X.data(), Y.data(), 3, 
+                         kNumFeat, kDataSize, full_param);
+  full_forest.Train();
+  EXPECT_EQ(full_forest.OOBError(), forest.OOBError());
+  ExpectSame(forest, full_forest, X);
+  // Stop at the same round
+  param.n_jobs = 4;
+  Forest parallel_forest;
+  parallel_forest.Initialize(X.data(), Y.data(), 3, 
+                             kNumFeat, kDataSize, param);
+  parallel_forest.Train();
+  EXPECT_EQ(parallel_forest.NumTree(), forest.NumTree());
+  EXPECT_EQ(parallel_forest.OOBError(), forest.OOBError());
+}
+
+TEST(ForestTest, Warm_start) {
+  std::vector<uint8> X;
+  std::vector<real_t> Y;
+  GenData(X, Y);
+  HyperParam param = GetParam();
+  param.oob_score = true;
+  Forest forest;
+  forest.Initialize(X.data(), Y.data(), 3, kNumFeat, kDataSize, param);
+  forest.Train();
+  // Train 10 trees, and then add 10 trees
+  std::vector<MaxMin> max_min(kNumFeat);
+  max_min[1].gap = 0.5;
+  param.n_estimators = 10;
+  Forest half_forest;
+  half_forest.Initialize(X.data(), Y.data(), 3, kNumFeat, kDataSize, param);
+  half_forest.Train();
+  half_forest.SetMaxMin(max_min);
+  half_forest.Save("/tmp/xforest_test.model");
+  Forest warm_forest;
+  warm_forest.Load("/tmp/xforest_test.model");
+  EXPECT_EQ(warm_forest.NumTree(), 10);
+  EXPECT_EQ(warm_forest.GetMaxMin().size(), kNumFeat);
+  EXPECT_EQ(warm_forest.GetMaxMin()[1].gap, 0.5);
+  param.n_estimators = 20;
+  param.warm_start = true;
+  param.n_jobs = 2;
+  warm_forest.Initialize(X.data(), Y.data(), 3, 
+                         kNumFeat, kDataSize, param, max_min);
+  warm_forest.Train();
+  EXPECT_EQ(warm_forest.NumTree(), 20);
+  EXPECT_EQ(warm_forest.NumOOBTree(), 20);
+  EXPECT_EQ(warm_forest.OOBError(), forest.OOBError());
+  ExpectSame(forest, warm_forest, X);
+  // Only the new trees vote on refreshed rows
+  std::vector<uint8> X_new(X.begin() + kNumFeat, X.end());
+  std::vector<real_t> Y_new(Y.begin() + 1, Y.end());
+  Forest refresh_forest;
+  refresh_forest.Load("/tmp/xforest_test.model");
+  refresh_forest.Initialize(X_new.data(), Y_new.data(), 3, kNumFeat, 
+                            kDataSize - 1, param, max_min);
+  refresh_forest.Train();
+  EXPECT_EQ(refresh_forest.NumTree(), 20);
+  EXPECT_EQ(refresh_forest.NumOOBTree(), 10);
+  // The first and later refreshes are the same
+  refresh_forest.Save("/tmp/xforest_test.model");
+  refresh_forest.Load("/tmp/xforest_test.model");
+  param.n_estimators = 25;
+  refresh_forest.Initialize(X_new.data(), Y_new.data(), 3, kNumFeat, 
+                            kDataSize - 1, param, max_min);
+  refresh_forest.Train();
+  EXPECT_EQ(refresh_forest.NumOOBTree(), 15);
+  RemoveFile("/tmp/xforest_test.model");
+}
+
+TEST(ForestTest, Warm_start_bins) {
+  std::vector<uint8> X;
+  std::vector<real_t> Y;
+  GenData(X, Y);
+  HyperParam param = GetParam();
+  param.n_estimators = 5;
+  std::vector<MaxMin> max_min(kNumFeat);
+  Forest forest;
+  forest.Initialize(X.data(), Y.data(), 3, 
+                    kNumFeat, kDataSize, param, max_min);
+  forest.Train();
+  EXPECT_EQ(forest.GetMaxMin().size(), kNumFeat);
+  param.n_estimators = 10;
+  param.warm_start = true;
+  EXPECT_DEATH(forest.Initialize(X.data(), Y.data(), 3, 
+                                 kNumFeat, kDataSize, param), 
+               "bin boundaries of the dataset");
+  max_min[2].min_feat = 1.0;
+  EXPECT_DEATH(forest.Initialize(X.data(), Y.data(), 3, 
+                                 kNumFeat, kDataSize, param, max_min), 
+               "feature 2");
+  Forest no_bin_forest;
+  param.warm_start = false;
+  no_bin_forest.Initialize(X.data(), Y.data(), 3, 
+                           kNumFeat, kDataSize, param);
+  no_bin_forest.Train();
+  param.warm_start = true;
+  EXPECT_DEATH(no_bin_forest.Initialize(X.data(), Y.data(), 3, 
+                                        kNumFeat, kDataSize, param, max_min),
+               "bin boundaries of the model");
+}
+
+TEST(ForestTest, Predict_raw) {
+  std::mt19937 rng(1231);
+  std::vector<real_t> X_raw(kNumFeat * kDataSize);
+  std::vector<real_t> Y(kDataSize);
+  for (index_t i = 0; i < kDataSize; ++i) {
+    real_t* row = X_raw.data() + i * kNumFeat;
+    for (index_t j = 0; j < kNumFeat; ++j) {
+      row[j] = (real_t)(rng() % 10000) / 100 - 20;
+    }
+    Y[i] = row[0] + row[1] > 60;
+  }
+  std::vector<MaxMin> max_min;
+  FindMaxMin(X_raw.data(), kNumFeat, kDataSize, kMaxBin, &max_min);
+  std::vector<uint8> X(kNumFeat * kDataSize);
+  BinData(X_raw.data(), kNumFeat, kDataSize, kMaxBin, max_min, X.data());
+  HyperParam param = GetParam();
+  Forest forest;
+  forest.Initialize(X.data(), Y.data(), 2, kNumFeat, kDataSize, param);
+  forest.Train();
+  forest.SetMaxMin(max_min);
+  for (index_t i = 0; i < kDataSize; ++i) {
+    EXPECT_EQ(forest.PredictRaw(X_raw.data() + i * kNumFeat),
+              forest.Predict(X.data() + i * kNumFeat));
+  }
+  // Bin boundaries are saved with the model
+  forest.Save("/tmp/xforest_test.model");
+  Forest load_forest;
+  load_forest.Load("/tmp/xforest_test.model", "flat");
+  for (index_t i = 0; i < kDataSize; ++i) {
+    EXPECT_EQ(load_forest.PredictRaw(X_raw.data() + i * kNumFeat),
+              forest.Predict(X.data() + i * kNumFeat));
+  }
+  // The used features are collected by Load() without a scorer
+  Forest raw_forest;
+  raw_forest.Load("/tmp/xforest_test.model", "");
+  for (index_t i = 0; i < kDataSize; ++i) {
+    EXPECT_EQ(raw_forest.PredictRaw(X_raw.data() + i * kNumFeat),
+              forest.Predict(X.data() + i * kNumFeat));
+  }
+  RemoveFile("/tmp/xforest_test.model");
+}
+
+TEST(ForestTest, Feature_importances) {
+  std::vector<uint8> X;
+  std::vector<real_t> Y;
+  GenData(X, Y);
+  HyperParam param = GetParam();
+  param.n_jobs = 4;
+  Forest forest;
+  forest.Initialize(X.data(), Y.data(), 3, kNumFeat, kDataSize, param);
+  forest.Train();
+  std::vector<real_t> importances;
+  forest.FeatureImportances(&importances);
+  EXPECT_EQ(importances.size(), kNumFeat);
+  real_t sum = 0;
+  for (real_t val : importances) {
+    sum += val;
+  }
+  EXPECT_NEAR(sum, 1.0, 1e-4);
+  // Label depends on the first three features
+  for (index_t j = 3; j < kNumFeat; ++j) {
+    EXPECT_GT(importances[0], importances[j]);
+    EXPECT_GT(importances[1], importances[j]);
+    EXPECT_GT(importances[2], importances[j]);
+  }
+}
+
+TEST(ForestTest, Online_update) {
+  std::vector<uint8> X;
+  std::vector<real_t> Y;
+  GenData(X, Y);
+  // Train with the first 100 rows
+  HyperParam param = GetParam();
+  param.grace_period = 50;
+  std::vector<MaxMin> max_min(kNumFeat);
+  Forest forest;
+  forest.Initialize(X.data(), Y.data(), 3, kNumFeat, 100, param, max_min);
+  forest.Train();
+  param.n_jobs = 4;
+  Forest parallel_forest;
+  parallel_forest.Initialize(X.data(), Y.data(), 3, kNumFeat, 100, param,
+                             max_min);
+  parallel_forest.Train();
+  auto accuracy = [&](Forest& f) {
+    index_t correct = 0;
+    for (index_t i = 0; i < kDataSize; ++i) {
+      if (f.Predict(X.data() + i * kNumFeat) == Y[i]) {
+        correct++;
+      }
+    }
+    return correct;
+  };
+  for (index_t begin = 100; begin + 500 <= kDataSize; begin += 500) {
+    Dataset batch(std::vector<uint8>(X.begin() + begin * kNumFeat,
+                                     X.begin() + (begin + 500) * kNumFeat),
+                  std::vector<real_t>(Y.begin() + begin, 
+                                      Y.begin() + begin + 500),
+                  3, kNumFeat, kMaxBin, max_min);
+    forest.Update(batch);
+    parallel_forest.Update(batch);
+  }
+  // Every tree improves, but the updated trees are less diverse
+  EXPECT_GT(accuracy(forest), kDataSize * 0.65);
+  ExpectSame(forest, parallel_forest, X);
+  // The batch must be binned like the model
+  std::vector<MaxMin> other_max_min(kNumFeat);
+  other_max_min[2].min_feat = 1.0;
+  Dataset other_batch(std::vector<uint8>(X.begin(), X.begin() + kNumFeat),
+                      std::vector<real_t>(Y.begin(), Y.begin() + 1),
+                      3, kNumFeat, kMaxBin, other_max_min);
+  EXPECT_DEATH(forest.Update(other_batch), "feature 2");
+  // The bootstrap of the next update goes on after Load()
+  int n_update = forest.NumUpdate();
+  EXPECT_GT(n_update, 0);
+  forest.Save("/tmp/xforest_test.model");
+  Forest load_forest;
+  load_forest.Load("/tmp/xforest_test.model");
+  EXPECT_EQ(load_forest.NumUpdate(), n_update);
+  RemoveFile("/tmp/xforest_test.model");
+}
+
+}  // namespace xforest
@@ -0,0 +1,88 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2018 by contributors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//------------------------------------------------------------------------------
+
+/*
+This file is the implementation of HistogramCache class.
+*/
+
+#include "src/tree/histogram_cache.h"
+
+namespace xforest {
+
+// Add histogram to cache
+void HistogramCache::Put(const DTNode* node, HistoBase* histo, int refs) {
+  CHECK_NOTNULL(histo);
+  CHECK_GT(refs, 0);
+  CHECK(map_.find(node) == map_.end());
+  lru_.push_front(node);
+  Entry entry;
+  entry.histo = histo;
+  entry.refs = refs;
+  entry.lru_iter = lru_.begin();
+  map_[node] = entry;
+  bytes_ += histo->Bytes();
+  if (bytes_ > peak_bytes_) {
+    peak_bytes_ = bytes_;
+  }
+  // Evict the least recently used histograms
+  while (max_bytes_ > 0 && bytes_ > max_bytes_ && lru_.size() > 1) {
+    Erase(map_.find(lru_.back()));
+    evictions_++;
+  }
+}
+
+// Get histogram from cache
+HistoBase* HistogramCache::Get(const DTNode* node) {
+  auto iter = map_.find(node);
+  if (iter == map_.end()) {
+    return nullptr;
+  }
+  // Move to the front of lru list
+  lru_.splice(lru_.begin(), lru_, iter->second.lru_iter);
+  return iter->second.histo;
+}
+
+// Release a reference of histogram
+void HistogramCache::Release(const DTNode* node) {
+  auto iter = map_.find(node);
+  if (iter == map_.end()) {
+    return;
+  }
+  if (--iter->second.refs == 0) {
+    Erase(iter);
+  }
+}
+
+// Delete all histograms
+void HistogramCache::Clear() {
+  for (auto& kv : map_) {
+    delete kv.second.histo;
+  }
+  map_.clear();
+  lru_.clear();
+  bytes_ = 0;
+}
+
+// Delete an entry
+void HistogramCache::Erase(
+  std::unordered_map<const DTNode*, Entry>::iterator iter) {
+  bytes_ -= iter->second.histo->Bytes();
+  lru_.erase(iter->second.lru_iter);
+  delete iter->second.histo;
+  map_.erase(iter);
+}
+
+}  // namespace xforest
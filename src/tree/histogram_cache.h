@@ -0,0 +1,160 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2018 by contributors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//------------------------------------------------------------------------------
+
+/*!
+*  Copyright (c) 2018 by Contributors
+* \file histogram_cache.h
+* \brief This file defines the HistogramCache class.
+*/
+#ifndef XFOREST_TREE_HISTOGRAM_CACHE_H_
+#define XFOREST_TREE_HISTOGRAM_CACHE_H_
+
+#include <list>
+#include <unordered_map>
+
+#include "src/base/common.h"
+
+namespace xforest {
+
+class DTNode;
+
+/*!
+* \brief Base class of the histogram bin data structures, so
+* that the cache can manage the histogram of any kind of tree.
+*/
+class HistoBase {
+ public:
+  virtual ~HistoBase() {}
+  /*!
+  * \brief Memory size (in bytes) of current histogram.
+  */
+  virtual uint64 Bytes() const = 0;
+};
+
+/*!
+* \brief HistogramCache owns the histograms of tree nodes that will
+* be used later for histogram subtraction (right = parent - brother).
+* Each histogram is stored with a reference count, which is the number
+* of its future users, and it is released when all users are done.
+* The cache has a byte budget, and when it is exceeded the least
+* recently used histograms are evicted. The user of an evicted histogram
+* gets a nullptr and should rebuild the histogram from data instead.
+* Basic usage:
+*
+*   HistogramCache cache(max_bytes);
+*   cache.Put(node, histo, 2);
+*   ...
+*   HistoBase* histo = cache.Get(node);
+*   if (histo == nullptr) {
+*     // Rebuild from data
+*   }
+*   cache.Release(node);
+*/
+class HistogramCache {
+ public:
+  /*!
+  * \brief Constructor and Destructor
+  * \param max_bytes byte budget of the cache (0 means unlimited)
+  */
+  explicit HistogramCache(uint64 max_bytes = 0)
+    : max_bytes_(max_bytes) { }
+  ~HistogramCache() { Clear(); }
+
+  /*!
+  * \brief Set byte budget of the cache (0 means unlimited).
+  */
+  inline void SetMaxBytes(uint64 max_bytes) {
+    max_bytes_ = max_bytes;
+  }
+
+  /*!
+  * \brief Add the histogram of a node to the cache. The cache takes
+  * the ownership of the histogram, and then evicts the least recently
+  * used histograms (except the new one) if the budget is exceeded.
+  * \param node tree node
+  * \param histo histogram of the node
+  * \param refs number of the future users of this histogram
+  */
+  void Put(const DTNode* node, HistoBase* histo, int refs);
+
+  /*!
+  * \brief Get the histogram of a node.
+  * \param node tree node
+  * \return nullptr if the histogram was evicted or never added
+  */
+  HistoBase* Get(const DTNode* node);
+
+  /*!
+  * \brief A user of the histogram is done, and the histogram
+  * is deleted when all of its users are done.
+  * \param node tree node
+  */
+  void Release(const DTNode* node);
+
+  /*!
+  * \brief Delete all histograms.
+  */
+  void Clear();
+
+  /*!
+  * \brief Current memory size (in bytes) of the cached histograms.
+  */
+  inline uint64 Bytes() const { return bytes_; }
+
+  /*!
+  * \brief Peak memory size (in bytes) of the cached histograms.
+  */
+  inline uint64 PeakBytes() const { return peak_bytes_; }
+
+  /*!
+  * \brief Number of the evicted histograms.
+  */
+  inline uint64 Evictions() const { return evictions_; }
+
+ protected:
+  /*!
+  * \brief Cache entry.
+  */
+  struct Entry {
+    HistoBase* histo;
+    int refs;
+    std::list<const DTNode*>::iterator lru_iter;
+  };
+  /*! \brief Byte budget (0 means unlimited) */
+  uint64 max_bytes_ = 0;
+  /*! \brief Current memory size */
+  uint64 bytes_ = 0;
+  /*! \brief Peak memory size */
+  uint64 peak_bytes_ = 0;
+  /*! \brief Number of evictions */
+  uint64 evictions_ = 0;
+  /*! \brief Cached histograms */
+  std::unordered_map<const DTNode*, Entry> map_;
+  /*! \brief Most recently used node is at the front */
+  std::list<const DTNode*> lru_;
+
+  /*!
+  * \brief Delete an entry from the cache.
+  */
+  void Erase(std::unordered_map<const DTNode*, Entry>::iterator iter);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HistogramCache);
+};
+
+}  // namespace xforest
+
+#endif  // XFOREST_TREE_HISTOGRAM_CACHE_H_
@@ -0,0 +1,77 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2018 by contributors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//------------------------------------------------------------------------------
+
+/*!
+*  Copyright (c) 2018 by Contributors
+* \file histogram_cache_test.cc
+* \brief This file tests histogram_cache.h file.
+*/
+#include "gtest/gtest.h"
+
+#include "src/base/common.h"
+#include "src/tree/histogram_cache.h"
+
+namespace xforest {
+
+int live_histo = 0;
+
+class TestHisto : public HistoBase {
+ public:
+  TestHisto() { live_histo++; }
+  ~TestHisto() { live_histo--; }
+  uint64 Bytes() const { return 100; }
+};
+
+const DTNode* Key(int id) {
+  return reinterpret_cast<const DTNode*>(id);
+}
+
+TEST(HistogramCacheTest, Release) {
+  HistogramCache cache;
+  cache.Put(Key(1), new TestHisto(), 2);
+  cache.Put(Key(2), new TestHisto(), 1);
+  EXPECT_EQ(cache.Bytes(), 200);
+  EXPECT_NE(cache.Get(Key(1)), nullptr);
+  cache.Release(Key(1));
+  EXPECT_NE(cache.Get(Key(1)), nullptr);
+  cache.Release(Key(1));
+  EXPECT_EQ(cache.Get(Key(1)), nullptr);
+  cache.Release(Key(1));
+  EXPECT_EQ(cache.Bytes(), 100);
+  EXPECT_EQ(live_histo, 1);
+  cache.Clear();
+  EXPECT_EQ(live_histo, 0);
+}
+
+TEST(HistogramCacheTest, Evict) {
+  HistogramCache cache(250);
+  cache.Put(Key(1), new TestHisto(), 1);
+  cache.Put(Key(2), new TestHisto(), 1);
+  // Key(1) is the most recently used now
+  EXPECT_NE(cache.Get(Key(1)), nullptr);
+  cache.Put(Key(3), new TestHisto(), 1);
+  EXPECT_EQ(cache.Evictions(), 1);
+  EXPECT_EQ(cache.Get(Key(2)), nullptr);
+  EXPECT_NE(cache.Get(Key(1)), nullptr);
+  EXPECT_NE(cache.Get(Key(3)), nullptr);
+  EXPECT_EQ(cache.Bytes(), 200);
+  EXPECT_EQ(cache.PeakBytes(), 300);
+  EXPECT_EQ(live_histo, 2);
+  cache.Clear();
+  EXPECT_EQ(live_histo, 0);
+}
+
+}  // namespace xforest
@@ -0,0 +1,132 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2018 by contributors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//------------------------------------------------------------------------------
+
+/*
+This file is the implementation of QuickScorer class.
+*/
+
+#include "src/tree/quick_scorer.h"
+
+#include <algorithm>
+
+namespace xforest {
+
+// Number of leaf nodes of a sub-tree
+static index_t CountLeaf(const DTNode* node) {
+  if (node->IsLeaf()) {
+    return 1;
+  }
+  return CountLeaf(node->LeftChild()) + CountLeaf(node->RightChild());
+}
+
+// Check the size of trees
+bool QuickScorer::Support(const std::vector<DTree*>& trees) {
+  for (const DTree* tree : trees) {
+    CHECK_NOTNULL(tree->Root());
+    if (CountLeaf(tree->Root()) > kMaxLeaf) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Build node masks
+void QuickScorer::Build(const std::vector<DTree*>& trees,
+                        uint8 num_class) {
+  CHECK(!trees.empty());
+  CHECK_GT(num_class, 0);
+  num_class_ = num_class;
+  num_tree_ = trees.size();
+  leaf_val_.assign((uint64)num_tree_ * kMaxLeaf, 0);
+  std::vector<SplitNode> nodes;
+  for (index_t t = 0; t < num_tree_; ++t) {
+    CHECK_NOTNULL(trees[t]->Root());
+    index_t num_leaf = 0;
+    VisitNode(trees[t]->Root(), t, &num_leaf, &nodes);
+  }
+  // Group by feature and sort by bin
+  std::sort(nodes.begin(), nodes.end(),
+    [](const SplitNode& a, const SplitNode& b) {
+      return a.feat_id != b.feat_id ? a.feat_id < b.feat_id :
+             a.bin_val < b.bin_val;
+  });
+  index_t num_feat = nodes.empty() ? 0 : nodes.back().feat_id + 1;
+  feat_begin_.assign(num_feat + 1, 0);
+  bins_.resize(nodes.size());
+  tree_ids_.resize(nodes.size());
+  masks_.resize(nodes.size());
+  for (size_t k = 0; k < nodes.size(); ++k) {
+    feat_begin_[nodes[k].feat_id + 1]++;
+    bins_[k] = nodes[k].bin_val;
+    tree_ids_[k] = nodes[k].tree_id;
+    masks_[k] = nodes[k].mask;
+  }
+  for (index_t j = 0; j < num_feat; ++j) {
+    feat_begin_[j + 1] += feat_begin_[j];
+  }
+}
+
+// Number leaf nodes from left to right
+void QuickScorer::VisitNode(const DTNode* node,
+                            index_t tree_id,
+                            index_t* num_leaf,
+                            std::vector<SplitNode>* nodes) {
+  if (node->IsLeaf()) {
+    CHECK_LT(*num_leaf, kMaxLeaf);
+    leaf_val_[(uint64)tree_id * kMaxLeaf + *num_leaf] = node->leaf_val;
+    (*num_leaf)++;
+    return;
+  }
+  index_t begin = *num_leaf;
+  VisitNode(node->LeftChild(), tree_id, num_leaf, nodes);
+  index_t end = *num_leaf;
+  VisitNode(node->RightChild(), tree_id, num_leaf, nodes);
+  // The right sub-tree has at least one leaf, so end - begin < 64
+  SplitNode split;
+  split.feat_id = node->BestFeatID();
+  split.bin_val = node->BestBinVal();
+  split.tree_id = tree_id;
+  split.mask = ~(((1ull << (end - begin)) - 1) << begin);
+  nodes->push_back(split);
+}
+
+// Majority vote of exit leaves
+real_t QuickScorer::Predict(const uint8* x) const {
+  // Reuse the buffers of current thread
+  static thread_local std::vector<uint64> leaves;
+  static thread_local std::vector<index_t> votes;
+  leaves.assign(num_tree_, kUInt64Max);
+  votes.assign(num_class_, 0);
+  uint64* leaf = leaves.data();
+  index_t num_feat = feat_begin_.empty() ? 0 : feat_begin_.size() - 1;
+  for (index_t j = 0; j < num_feat; ++j) {
+    uint8 val = x[j];
+    index_t end = feat_begin_[j + 1];
+    // The nodes with bin < val go right
+    for (index_t k = feat_begin_[j]; k < end && bins_[k] < val; ++k) {
+      leaf[tree_ids_[k]] &= masks_[k];
+    }
+  }
+  const real_t* leaf_val = leaf_val_.data();
+  for (index_t t = 0; t < num_tree_; ++t) {
+    votes[(index_t)leaf_val[__builtin_ctzll(leaf[t])]]++;
+    leaf_val += kMaxLeaf;
+  }
+  return (real_t)std::distance(votes.begin(),
+    std::max_element(votes.begin(), votes.end()));
+}
+
+}  // namespace xforest
@@ -0,0 +1,133 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2018 by contributors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//------------------------------------------------------------------------------
+
+/*!
+*  Copyright (c) 2018 by Contributors
+* \file quick_scorer.h
+* \brief This file defines the QuickScorer class.
+*/
+#ifndef XFOREST_TREE_QUICK_SCORER_H_
+#define XFOREST_TREE_QUICK_SCORER_H_
+
+#include <vector>
+
+#include "src/base/common.h"
+#include "src/tree/dtree.h"
+
+namespace xforest {
+
+/*!
+* \brief QuickScorer predicts by a forest of small trees (at most 64
+* leaf nodes each) without walking the trees. The leaf nodes of a tree
+* are numbered from left to right, and the tree keeps a 64-bit vector of
+* the leaf nodes that can still be reached. A split node whose test
+* fails (x[feat] > bin, i.e., goes right) clears the bits of the leaf
+* nodes of its left sub-tree, and the exit leaf is then the lowest set
+* bit. The split nodes of all trees are grouped by feature and sorted by
+* bin, so for each feature only the nodes with bin < x[feat] are visited
+* in one forward scan, and the masks are applied in any order. Basic usage:
+*
+*   QuickScorer scorer;
+*   if (QuickScorer::Support(trees)) {
+*     scorer.Build(trees, num_class);
+*     real_t y = scorer.Predict(x);
+*   }
+*
+* The trees are copied, so they can be deleted afterwards.
+*/
+class QuickScorer {
+ public:
+  /*!
+  * \brief Constructor and Destructor
+  */
+  QuickScorer() { }
+  ~QuickScorer() { }
+
+  /*! \brief Maximal number of leaf nodes of a tree */
+  static const index_t kMaxLeaf = 64;
+
+  /*!
+  * \brief Wether all trees have at most kMaxLeaf leaf nodes.
+  */
+  static bool Support(const std::vector<DTree*>& trees);
+
+  /*!
+  * \brief Build the node masks of the trees.
+  * \param trees trained (or deserilized) trees
+  * \param num_class number of classification
+  */
+  void Build(const std::vector<DTree*>& trees, uint8 num_class);
+
+  /*!
+  * \brief Given data x, predict label y by majority vote.
+  * \param x pointer of data example
+  * \return predicted label y
+  */
+  real_t Predict(const uint8* x) const;
+
+  /*!
+  * \brief Number of trees.
+  */
+  inline index_t NumTree() const {
+    return num_tree_;
+  }
+
+ protected:
+  /*! \brief Number of classification */
+  uint8 num_class_ = 0;
+  /*! \brief Number of trees */
+  index_t num_tree_ = 0;
+  /*! \brief Start of the split nodes of each feature */
+  std::vector<index_t> feat_begin_;
+  /*! \brief Split bin value of the nodes, sorted in each feature */
+  std::vector<uint8> bins_;
+  /*! \brief Tree id of the nodes */
+  std::vector<index_t> tree_ids_;
+  /*! \brief Bits of the reachable leaf nodes if the node goes right */
+  std::vector<uint64> masks_;
+  /*! \brief Leaf values of tree t start at t * kMaxLeaf */
+  std::vector<real_t> leaf_val_;
+
+  /*!
+  * \brief Split node of a tree.
+  */
+  struct SplitNode {
+    index_t feat_id;
+    uint8 bin_val;
+    index_t tree_id;
+    uint64 mask;
+  };
+
+  /*!
+  * \brief Number the leaf nodes of a sub-tree from left to right,
+  * and collect the split nodes.
+  * \param node root of the sub-tree
+  * \param tree_id id of the tree
+  * \param num_leaf number of leaf nodes visited
+  * \param nodes split nodes
+  */
+  void VisitNode(const DTNode* node,
+                 index_t tree_id,
+                 index_t* num_leaf,
+                 std::vector<SplitNode>* nodes);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(QuickScorer);
+};
+
+}  // namespace xforest
+
+#endif  // XFOREST_TREE_QUICK_SCORER_H_
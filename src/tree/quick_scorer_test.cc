@@ -0,0 +1,100 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2018 by contributors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//------------------------------------------------------------------------------
+
+/*!
+*  Copyright (c) 2018 by Contributors
+* \file quick_scorer_test.cc
+* \brief This file tests quick_scorer.h file.
+*/
+#include "gtest/gtest.h"
+
+#include <vector>
+
+#include "src/base/common.h"
+#include "src/base/stl-util.h"
+#include "src/base/timer.h"
+#include "src/tree/quick_scorer.h"
+#include "src/tree/test_util.h"
+
+namespace xforest {
+
+static const index_t kNumFeat = 8;
+static const index_t kDataSize = 2000;
+static const index_t kNumTree = 16;
+
+TEST(QuickScorerTest, Predict) {
+  std::vector<uint8> X;
+  std::vector<real_t> Y;
+  GenData(kNumFeat, kDataSize, X, Y);
+  std::vector<DTree*> trees;
+  BuildTrees(X, Y, kNumFeat, kNumTree, 64, &trees);
+  ASSERT_TRUE(QuickScorer::Support(trees));
+  QuickScorer scorer;
+  scorer.Build(trees, 3);
+  EXPECT_EQ(scorer.NumTree(), kNumTree);
+  for (index_t i = 0; i < kDataSize; ++i) {
+    const uint8* x = X.data() + i * kNumFeat;
+    EXPECT_EQ(scorer.Predict(x), Vote(trees, x));
+  }
+  STLDeleteElementsAndClear(&trees);
+}
+
+TEST(QuickScorerTest, Support) {
+  std::vector<uint8> X;
+  std::vector<real_t> Y;
+  GenData(kNumFeat, kDataSize, X, Y);
+  std::vector<DTree*> trees;
+  BuildTrees(X, Y, kNumFeat, kNumTree, 200, &trees);
+  EXPECT_FALSE(QuickScorer::Support(trees));
+  STLDeleteElementsAndClear(&trees);
+}
+
+TEST(QuickScorerTest, Benchmark) {
+  std::vector<uint8> X;
+  std::vector<real_t> Y;
+  GenData(kNumFeat, kDataSize, X, Y);
+  std::vector<DTree*> trees;
+  BuildTrees(X, Y, kNumFeat, kNumTree, 32, &trees);
+  QuickScorer scorer;
+  scorer.Build(trees, 3);
+  // Labels of the timed rows, which are checked row by row
+  std::vector<real_t> tree_pred(kDataSize);
+  std::vector<real_t> scorer_pred(kDataSize);
+  Timer timer;
+  timer.tic();
+  for (int k = 0; k < 20; ++k) {
+    for (index_t i = 0; i < kDataSize; ++i) {
+      tree_pred[i] = Vote(trees, X.data() + i * kNumFeat);
+    }
+  }
+  float tree_time = timer.toc();
+  timer.reset();
+  timer.tic();
+  for (int k = 0; k < 20; ++k) {
+    for (index_t i = 0; i < kDataSize; ++i) {
+      scorer_pred[i] = scorer.Predict(X.data() + i * kNumFeat);
+    }
+  }
+  float scorer_time = timer.toc();
+  printf("Pointer traversal: %.3f sec, QuickScorer: %.3f sec\n",
+         tree_time, scorer_time);
+  for (index_t i = 0; i < kDataSize; ++i) {
+    EXPECT_EQ(tree_pred[i], scorer_pred[i]) << "row " << i;
+  }
+  STLDeleteElementsAndClear(&trees);
+}
+
+}  // namespace xforest
@@ -0,0 +1,104 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2018 by contributors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//------------------------------------------------------------------------------
+
+/*!
+*  Copyright (c) 2018 by Contributors
+* \file test_util.h
+* \brief This file defines the datasets and trees shared by the tests
+* of the compiled scorers, which compare their predictions with the
+* pointer traversal of the same trees.
+*/
+#ifndef XFOREST_TREE_TEST_UTIL_H_
+#define XFOREST_TREE_TEST_UTIL_H_
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "src/base/common.h"
+#include "src/solver/hyper_parameter.h"
+#include "src/tree/dtree.h"
+
+namespace xforest {
+
+static const uint8 kMaxBin = 63;
+
+// Generate a noisy dataset with 3 classes, which
+// depends on the first and the last features
+inline void GenData(index_t num_feat,
+                    index_t data_size,
+                    std::vector<uint8>& X,
+                    std::vector<real_t>& Y) {
+  std::mt19937 rng(1231);
+  X.resize((uint64)num_feat * data_size);
+  Y.resize(data_size);
+  for (index_t i = 0; i < data_size; ++i) {
+    uint8* row = X.data() + (uint64)i * num_feat;
+    for (index_t j = 0; j < num_feat; ++j) {
+      row[j] = rng() % (kMaxBin + 1);
+    }
+    Y[i] = (row[0] + row[num_feat - 1] + rng() % 32) * 3 / 
+           (kMaxBin * 2 + 32);
+  }
+}
+
+// Hyper-parameters of deep trees
+inline HyperParam GetParam(int max_leaf_nodes = 1000) {
+  HyperParam param;
+  param.max_bin = kMaxBin;
+  param.max_depth = 12;
+  param.max_leaf_nodes = max_leaf_nodes;
+  return param;
+}
+
+// Trees on different features: tree t does not use feature
+// t % num_feat, so tree t + num_feat is the same as t
+inline void BuildTrees(const std::vector<uint8>& X,
+                       const std::vector<real_t>& Y,
+                       index_t num_feat,
+                       index_t num_tree,
+                       int max_leaf_nodes,
+                       std::vector<DTree*>* trees) {
+  HyperParam param = GetParam(max_leaf_nodes);
+  index_t data_size = Y.size();
+  for (index_t t = 0; t < num_tree; ++t) {
+    DTree* tree = CREATE_DTREE("mctree");
+    tree->Initialize(X.data(), Y.data(), 3, num_feat, data_size, param);
+    std::vector<index_t> col_idx;
+    for (index_t j = 0; j < num_feat; ++j) {
+      if (j != t % num_feat) {
+        col_idx.push_back(j);
+      }
+    }
+    tree->SetColIdx(col_idx);
+    tree->BuildTree();
+    trees->push_back(tree);
+  }
+}
+
+// Majority vote by pointer traversal
+inline real_t Vote(const std::vector<DTree*>& trees, const uint8* x) {
+  std::vector<index_t> votes(3, 0);
+  for (DTree* tree : trees) {
+    votes[(index_t)tree->Predict(x)]++;
+  }
+  return (real_t)std::distance(votes.begin(),
+    std::max_element(votes.begin(), votes.end()));
+}
+
+}  // namespace xforest
+
+#endif  // XFOREST_TREE_TEST_UTIL_H_
@@ -0,0 +1,219 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2018 by contributors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//------------------------------------------------------------------------------
+
+/*
+This file is the implementation of TreeBatch class.
+*/
+
+#include "src/tree/tree_batch.h"
+
+#include <algorithm>
+
+#include "src/base/stl-util.h"
+
+namespace xforest {
+
+// Add a tree to current batch
+void TreeBatch::AddTree(DTree* tree) {
+  MCTree* mc_tree = dynamic_cast<MCTree*>(tree);
+  CHECK_NOTNULL(mc_tree);
+  if (!trees_.empty()) {
+    CHECK(mc_tree->X_ == trees_[0]->X_);
+    CHECK(mc_tree->Y_ == trees_[0]->Y_);
+    CHECK_EQ(mc_tree->num_feat_, trees_[0]->num_feat_);
+    CHECK_EQ(mc_tree->data_size_, trees_[0]->data_size_);
+  }
+  trees_.push_back(mc_tree);
+}
+
+// Grow all trees in current batch
+void TreeBatch::BuildTrees() {
+  if (trees_.empty()) {
+    return;
+  }
+  index_t data_size = trees_[0]->data_size_;
+  std::vector<TreeState> states(trees_.size());
+  for (size_t t = 0; t < trees_.size(); ++t) {
+    MCTree* tree = trees_[t];
+    TreeState& state = states[t];
+    tree->ResetTree();
+    tree->InitSample();
+    state.tree = tree;
+    // Every sampled row starts from root
+    state.slot.assign(data_size, -1);
+    state.weight.assign(data_size, 0);
+    for (index_t row_idx : tree->rowIdx_) {
+      CHECK_LT(state.weight[row_idx], 0xFFFF);
+      state.weight[row_idx]++;
+      state.slot[row_idx] = 0;
+    }
+    tree->root_ = new DTNode();
+    tree->root_->SetLeftOrRight('l');
+    tree->root_->SetLevel(1);
+    state.frontier.push_back(tree->root_);
+    state.build.push_back(true);
+    state.parent.push_back(-1);
+  }
+  for (;;) {
+    bool active = false;
+    for (TreeState& state : states) {
+      MCTree* tree = state.tree;
+      for (size_t i = 0; i < state.frontier.size(); ++i) {
+        state.histo.push_back(new MCHistogram(tree->colIdx_.size(),
+                                              tree->max_bin_ + 1,
+                                              tree->num_class_));
+      }
+      active |= !state.frontier.empty();
+    }
+    if (!active) {
+      break;
+    }
+    Sweep(states);
+    for (TreeState& state : states) {
+      if (!state.frontier.empty()) {
+        SplitLevel(state);
+      }
+    }
+  }
+}
+
+// One sweep over the dataset
+void TreeBatch::Sweep(std::vector<TreeState>& states) {
+  // Only visit the growing trees
+  std::vector<TreeState*> active;
+  for (TreeState& state : states) {
+    if (!state.frontier.empty()) {
+      active.push_back(&state);
+    }
+  }
+  const MCTree* first = active[0]->tree;
+  const uint8* X = first->X_;
+  const real_t* Y = first->Y_;
+  index_t num_feat = first->num_feat_;
+  index_t data_size = first->data_size_;
+  for (index_t r = 0; r < data_size; ++r) {
+    const uint8* ptr = X + (uint64)r * num_feat;
+    index_t y = (index_t)Y[r];
+    for (TreeState* state : active) {
+      int32 s = state->slot[r];
+      if (s < 0) {
+        continue;
+      }
+      // Route the row to the node of current level
+      if (!state->route.empty()) {
+        const Route& route = state->route[s];
+        if (route.left < 0) {
+          state->slot[r] = -1;
+          continue;
+        }
+        s = ptr[route.feat_id] <= route.bin_val ? route.left : route.right;
+        state->slot[r] = s;
+      }
+      if (!state->build[s]) {
+        continue;
+      }
+      const MCTree* tree = state->tree;
+      const index_t* col_idx = tree->colIdx_.data();
+      index_t col_size = tree->colIdx_.size();
+      index_t num_class = tree->num_class_;
+      index_t w = state->weight[r];
+      index_t* count = state->histo[s]->count;
+      for (index_t j = 0; j < col_size; ++j) {
+        count[num_class*(ptr[col_idx[j]]*col_size+j)+y] += w;
+      }
+    }
+  }
+}
+
+// Split the frontier nodes of a tree
+void TreeBatch::SplitLevel(TreeState& state) {
+  MCTree* tree = state.tree;
+  std::vector<DTNode*> frontier;
+  std::vector<bool> build;
+  std::vector<int32> parent;
+  std::vector<Route> route(state.frontier.size());
+  std::vector<index_t> total_count;
+  index_t last_len = 0;
+  for (size_t i = 0; i < state.frontier.size(); ++i) {
+    DTNode* node = state.frontier[i];
+    MCHistogram* histo = state.histo[i];
+    // histo = parent_histo - brother_histo
+    if (!state.build[i]) {
+      index_t* count = histo->count;
+      const index_t* count_parent = 
+        state.last_histo[state.parent[i]]->count;
+      const index_t* count_brother = state.histo[i-1]->count;
+      for (index_t k = 0; k < histo->count_len; ++k) {
+        count[k] = count_parent[k] - count_brother[k];
+      }
+    }
+    tree->TotalCount(histo, &total_count);
+    index_t len = 0;
+    for (index_t c : total_count) {
+      len += c;
+    }
+    // Brother (the left child) is the last node
+    if (!state.build[i]) {
+      node->Parent()->SetHotRight(len > last_len);
+    }
+    last_len = len;
+    if (tree->IsLeaf(node, len) || !tree->FindSplit(node, histo, len)) {
+      node->SetLeaf();
+      node->SetLeafVal((real_t)std::distance(total_count.begin(),
+        std::max_element(total_count.begin(), total_count.end())));
+    } else {
+      // New left child
+      DTNode* l_node = new DTNode();
+      l_node->SetLeftOrRight('l');
+      l_node->SetLevel(node->Level() + 1);
+      // New right child
+      DTNode* r_node = new DTNode();
+      r_node->SetLeftOrRight('r');
+      r_node->SetLevel(node->Level() + 1);
+      r_node->SetParent(node);
+      r_node->SetBrother(l_node);
+      node->SetLeftChild(l_node);
+      node->SetRightChild(r_node);
+      route[i].feat_id = node->BestFeatID();
+      route[i].bin_val = node->BestBinVal();
+      route[i].left = frontier.size();
+      route[i].right = frontier.size() + 1;
+      frontier.push_back(l_node);
+      frontier.push_back(r_node);
+      // Right node uses histogram subtraction
+      build.push_back(true);
+      build.push_back(false);
+      parent.push_back(i);
+      parent.push_back(i);
+      if (r_node->Level() > tree->tree_depth_) {
+        tree->tree_depth_ = r_node->Level();
+      }
+      tree->leaf_size_++;
+    }
+    node->Clear();
+  }
+  STLDeleteElementsAndClear(&state.last_histo);
+  state.last_histo.swap(state.histo);
+  state.frontier.swap(frontier);
+  state.build.swap(build);
+  state.parent.swap(parent);
+  state.route.swap(route);
+  if (state.frontier.empty()) {
+    STLDeleteElementsAndClear(&state.last_histo);
+  }
+}
+
+}  // namespace xforest
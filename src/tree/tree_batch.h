@@ -0,0 +1,135 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2018 by contributors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//------------------------------------------------------------------------------
+
+/*!
+*  Copyright (c) 2018 by Contributors
+* \file tree_batch.h
+* \brief This file defines the TreeBatch class.
+*/
+#ifndef XFOREST_TREE_TREE_BATCH_H_
+#define XFOREST_TREE_TREE_BATCH_H_
+
+#include <vector>
+
+#include "src/base/common.h"
+#include "src/tree/dtree.h"
+
+namespace xforest {
+
+/*!
+* \brief TreeBatch grows a group of classification trees (MCTree)
+* together, level by level. Each tree maps every row of the dataset
+* to its frontier node (or to none), and one sweep over the dataset
+* per level routes each row to its new node and updates the histograms
+* of the frontier nodes of all trees. Hence the dataset is read once
+* per level for the whole group instead of once per tree. Basic usage:
+*
+*   TreeBatch batch;
+*   for (...) {
+*     tree->Initialize(X, Y, ...);
+*     tree->SetRowIdx(row_idx);
+*     tree->SetColIdx(col_idx);
+*     batch.AddTree(tree);
+*   }
+*   batch.BuildTrees();
+*
+* All trees in a batch must share the same dataset. The trees are the
+* same as the ones grown by DTree::BuildTree() in breadth-first order.
+* Note that each tree costs 6 bytes per row of the dataset for its
+* row-to-node map, and keeps the histograms of two levels alive. The
+* batch is grown by the calling thread without prefetching, and the
+* grow_policy, reorder_data and max_histogram_bytes of the trees are
+* not used (Forest rejects them with tree_batch_size > 1).
+*/
+class TreeBatch {
+ public:
+  /*!
+  * \brief Constructor and Destructor
+  */
+  TreeBatch() { }
+  ~TreeBatch() { }
+
+  /*!
+  * \brief Add a tree to current batch.
+  * \param tree an initialized MCTree
+  */
+  void AddTree(DTree* tree);
+
+  /*!
+  * \brief Grow all trees in current batch.
+  */
+  void BuildTrees();
+
+  /*!
+  * \brief Number of trees in current batch.
+  */
+  inline size_t Size() const {
+    return trees_.size();
+  }
+
+ protected:
+  /*!
+  * \brief Where the rows of a node go in the next level.
+  */
+  struct Route {
+    index_t feat_id = 0;
+    uint8 bin_val = 0;
+    /*! \brief slot of the children, -1 for a leaf node */
+    int32 left = -1;
+    int32 right = -1;
+  };
+  /*!
+  * \brief Growing state of a tree.
+  */
+  struct TreeState {
+    MCTree* tree = nullptr;
+    /*! \brief Frontier slot of each row, -1 for none */
+    std::vector<int32> slot;
+    /*! \brief Bootstrap multiplicity of each row */
+    std::vector<uint16> weight;
+    /*! \brief Nodes in current level */
+    std::vector<DTNode*> frontier;
+    /*! \brief Wether to build the histogram from data */
+    std::vector<bool> build;
+    /*! \brief Slot of the parent in last level */
+    std::vector<int32> parent;
+    /*! \brief Histograms of current and last level */
+    std::vector<MCHistogram*> histo;
+    std::vector<MCHistogram*> last_histo;
+    /*! \brief Routes of the nodes in last level */
+    std::vector<Route> route;
+  };
+  /*! \brief Trees in current batch */
+  std::vector<MCTree*> trees_;
+
+  /*!
+  * \brief One sweep over the dataset for current level.
+  */
+  void Sweep(std::vector<TreeState>& states);
+
+  /*!
+  * \brief Split the frontier nodes of a tree, and
+  * set up the frontier of the next level.
+  */
+  void SplitLevel(TreeState& state);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(TreeBatch);
+};
+
+}  // namespace xforest
+
+#endif  // XFOREST_TREE_TREE_BATCH_H_
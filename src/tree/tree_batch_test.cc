@@ -0,0 +1,101 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2018 by contributors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//------------------------------------------------------------------------------
+
+/*!
+*  Copyright (c) 2018 by Contributors
+* \file tree_batch_test.cc
+* \brief This file tests tree_batch.h file.
+*/
+#include "gtest/gtest.h"
+
+#include <vector>
+#include <random>
+
+#include "src/base/common.h"
+#include "src/tree/flat_tree.h"
+#include "src/tree/tree_batch.h"
+
+namespace xforest {
+
+static const index_t kNumFeat = 8;
+static const index_t kDataSize = 3000;
+static const uint8 kMaxBin = 63;
+static const int kNumTree = 5;
+
+TEST(TreeBatchTest, Same_as_single_tree) {
+  std::mt19937 rng(1231);
+  std::vector<uint8> X(kNumFeat * kDataSize);
+  std::vector<real_t> Y(kDataSize);
+  for (index_t i = 0; i < kDataSize; ++i) {
+    uint8* row = X.data() + i * kNumFeat;
+    for (index_t j = 0; j < kNumFeat; ++j) {
+      row[j] = rng() % (kMaxBin + 1);
+    }
+    Y[i] = (row[0] + row[1] + rng() % 16) % 3;
+  }
+  HyperParam param;
+  param.max_bin = kMaxBin;
+  param.max_depth = 12;
+  param.max_leaf_nodes = 100;
+  TreeBatch batch;
+  std::vector<DTree*> single_trees;
+  std::vector<DTree*> batch_trees;
+  for (int t = 0; t < kNumTree; ++t) {
+    // Bootstrap samples and feature samples
+    std::vector<index_t> row_idx(kDataSize);
+    for (index_t i = 0; i < kDataSize; ++i) {
+      row_idx[i] = rng() % kDataSize;
+    }
+    std::vector<index_t> col_idx;
+    for (index_t j = 0; j < kNumFeat; ++j) {
+      if (j < 2 || rng() % 2 == 0) {
+        col_idx.push_back(j);
+      }
+    }
+    DTree* single_tree = CREATE_DTREE("mctree");
+    DTree* batch_tree = CREATE_DTREE("mctree");
+    for (DTree* tree : { single_tree, batch_tree }) {
+      tree->Initialize(X.data(), Y.data(), 3, kNumFeat, kDataSize, param);
+      tree->SetRowIdx(row_idx);
+      tree->SetColIdx(col_idx);
+    }
+    single_tree->BuildTree();
+    batch.AddTree(batch_tree);
+    single_trees.push_back(single_tree);
+    batch_trees.push_back(batch_tree);
+  }
+  EXPECT_EQ(batch.Size(), kNumTree);
+  batch.BuildTrees();
+  for (int t = 0; t < kNumTree; ++t) {
+    for (index_t i = 0; i < kDataSize; ++i) {
+      const uint8* x = X.data() + i * kNumFeat;
+      EXPECT_EQ(single_trees[t]->Predict(x), batch_trees[t]->Predict(x));
+    }
+    // Same layout with the same hot children
+    FlatTree single_flat;
+    FlatTree batch_flat;
+    single_flat.Flatten(*single_trees[t]);
+    batch_flat.Flatten(*batch_trees[t]);
+    ASSERT_EQ(single_flat.NumNode(), batch_flat.NumNode());
+    for (size_t k = 0; k < single_flat.NumNode(); ++k) {
+      EXPECT_EQ(single_flat.Nodes()[k].child, batch_flat.Nodes()[k].child);
+    }
+    delete single_trees[t];
+    delete batch_trees[t];
+  }
+}
+
+}  // namespace xforest